@@ -0,0 +1,64 @@
+local sdl = require 'sdl'
+
+
+sdl.init(sdl.INIT_VIDEO | sdl.INIT_AUDIO)
+
+local window = sdl.create_window("SDL3 Audio Demo", 800, 600, sdl.WINDOW_RESIZABLE)
+local window_id = window.windowID
+
+local renderer, err = sdl.create_renderer(window)
+if not renderer then
+    print("Error creating renderer: " .. (err or "Unknown error"))
+    return
+end
+
+local driver = sdl.open_audio()
+print("Audio driver: " .. driver)
+print("Click to play a tone (x = pan, y = pitch), SPACE plays 64 at once. ESC to exit.")
+
+-- Build a 16-bit mono WAV in memory, the same path assets from a pack would take
+local function make_tone(freq, seconds, rate)
+    local samples = {}
+    local count = math.floor(seconds * rate)
+    for i = 0, count - 1 do
+        local fade = 1 - i / count
+        samples[#samples + 1] = string.pack("<i2", math.floor(math.sin(2 * math.pi * freq * i / rate) * 12000 * fade))
+    end
+    local data = table.concat(samples)
+    return "RIFF" .. string.pack("<I4", 36 + #data) .. "WAVE" ..
+        "fmt " .. string.pack("<I4I2I2I4I4I2I2", 16, 1, 1, rate, rate * 2, 2, 16) ..
+        "data" .. string.pack("<I4", #data) .. data
+end
+
+local tone = sdl.load_sound_data(make_tone(440, 0.4, 22050))
+local drone = sdl.open_sound_stream_data(make_tone(110, 4.0, 44100))
+sdl.play_stream(drone, 0.3, 0, 1, true)
+
+while true do
+    local events = sdl.poll_events()
+    for i, event in ipairs(events) do
+        if event.type == sdl.QUIT or (event.type == sdl.WINDOW_CLOSE and event.window_id == window_id) then
+            print("Window closed.")
+            sdl.close_audio()
+            return
+        elseif event.type == sdl.KEY_DOWN and event.keycode == sdl.KEY_ESCAPE then
+            print("ESC pressed. Exiting.")
+            sdl.close_audio()
+            return
+        elseif event.type == sdl.KEY_DOWN and event.key_name == "Space" then
+            for n = 1, 64 do
+                sdl.play_sound(tone, 0.05, math.random() * 2 - 1, 0.5 + math.random() * 1.5)
+            end
+        elseif event.type == sdl.MOUSE_BUTTON_DOWN and event.button == sdl.BUTTON_LEFT then
+            sdl.play_sound(tone, 0.8, event.x / 400 - 1, 2 - event.y / 400)
+        end
+    end
+
+    local buffers, avg_us, max_us, load, voices, underruns = sdl.audio_stats()
+    sdl.set_render_draw_color(renderer, 20, 20, 30, 255)
+    sdl.render_clear(renderer)
+    sdl.set_render_draw_color(renderer, 255, 255, 255, 255)
+    sdl.render_debug_text(renderer, 10, 10, string.format("voices %d  buffers %d  underruns %d", voices, buffers, underruns))
+    sdl.render_debug_text(renderer, 10, 24, string.format("mix avg %.1f us  max %.1f us  load %.3f%%", avg_us, max_us, load * 100))
+    sdl.render_present(renderer)
+end
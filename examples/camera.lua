@@ -0,0 +1,74 @@
+local sdl = require 'sdl'
+
+sdl.init(sdl.INIT_VIDEO)
+
+local window = sdl.create_window("SDL3 Camera Demo", 800, 600, sdl.WINDOW_RESIZABLE)
+local window_id = window.windowID
+
+local renderer, err = sdl.create_renderer(window)
+if not renderer then
+    print("Error creating renderer: " .. (err or "Unknown error"))
+    return
+end
+
+print("Drag with the left mouse button to pan. Press ESC or close to exit.")
+
+-- World space points, built once; the camera is applied in C every frame
+local points = {}
+for y = 0, 199 do
+    for x = 0, 199 do
+        points[#points + 1] = {x = x * 10, y = y * 10}
+    end
+end
+
+local cam_x, cam_y = 1000, 1000
+local dragging = false
+local t = 0
+
+while true do
+    local events = sdl.poll_events()
+    for i, event in ipairs(events) do
+        if event.type == sdl.QUIT or (event.type == sdl.WINDOW_CLOSE and event.window_id == window_id) then
+            print("Window closed.")
+            return
+        elseif event.type == sdl.KEY_DOWN and event.keycode == sdl.KEY_ESCAPE then
+            print("ESC pressed. Exiting.")
+            return
+        elseif event.type == sdl.MOUSE_BUTTON_DOWN and event.button == sdl.BUTTON_LEFT then
+            dragging = true
+        elseif event.type == sdl.MOUSE_BUTTON_UP and event.button == sdl.BUTTON_LEFT then
+            dragging = false
+        elseif event.type == sdl.MOUSE_MOTION and dragging then
+            cam_x = cam_x - event.xrel
+            cam_y = cam_y - event.yrel
+        end
+    end
+
+    t = t + 0.01
+    local zoom = 1 + 0.5 * math.sin(t)
+
+    sdl.set_render_draw_color(renderer, 20, 20, 40, 255)
+    sdl.render_clear(renderer)
+
+    sdl.push_transform(renderer)
+    sdl.translate(renderer, 400, 300)
+    sdl.scale(renderer, zoom)
+    sdl.rotate(renderer, t * 0.2)
+    sdl.translate(renderer, -cam_x, -cam_y)
+
+    sdl.set_render_draw_color(renderer, 255, 255, 255, 255)
+    sdl.render_points(renderer, points)
+    sdl.set_render_draw_color(renderer, 255, 128, 0, 255)
+    sdl.render_fill_circle(renderer, 1000, 1000, 40)
+    sdl.render_rect(renderer, 900, 900, 200, 200)
+    sdl.pop_transform(renderer)
+
+    sdl.set_render_draw_color(renderer, 255, 0, 0, 255)
+    sdl.render_debug_text(renderer, 10, 10, string.format("zoom %.2f", zoom))
+
+    sdl.render_present(renderer)
+end
+
+sdl.destroy_window(window)
+window = nil
+sdl.quit()
@@ -0,0 +1,88 @@
+local sdl = require 'sdl'
+
+math.randomseed(1)
+
+sdl.init(sdl.INIT_VIDEO)
+
+local window = sdl.create_window("SDL3 Collision Demo", 800, 600, sdl.WINDOW_RESIZABLE)
+local window_id = window.windowID
+
+local renderer, err = sdl.create_renderer(window)
+if not renderer then
+    print("Error creating renderer: " .. (err or "Unknown error"))
+    return
+end
+
+print("Bodies turn red while overlapping. Click to remove bodies under the mouse. ESC to exit.")
+
+local world = sdl.create_world(32)
+local bodies = {}
+for i = 1, 2000 do
+    local b = {
+        x = math.random(0, 780), y = math.random(0, 580),
+        vx = math.random(-60, 60), vy = math.random(-60, 60),
+        circle = i % 2 == 0, size = math.random(4, 10)
+    }
+    if b.circle then
+        b.id = sdl.world_add_circle(world, b.x, b.y, b.size)
+    else
+        b.id = sdl.world_add_rect(world, b.x, b.y, b.size * 2, b.size * 2)
+    end
+    bodies[b.id] = b
+end
+
+local pairs_out, hits_out, hit = {}, {}, {}
+local last = sdl.get_ticks()
+
+while true do
+    local events = sdl.poll_events()
+    for i, event in ipairs(events) do
+        if event.type == sdl.QUIT or (event.type == sdl.WINDOW_CLOSE and event.window_id == window_id) then
+            print("Window closed.")
+            return
+        elseif event.type == sdl.KEY_DOWN and event.keycode == sdl.KEY_ESCAPE then
+            print("ESC pressed. Exiting.")
+            return
+        elseif event.type == sdl.MOUSE_BUTTON_DOWN and event.button == sdl.BUTTON_LEFT then
+            for _, id in ipairs(sdl.world_query_point(world, event.x, event.y, hits_out)) do
+                sdl.world_remove(world, id)
+                bodies[id] = nil
+            end
+        end
+    end
+
+    local now = sdl.get_ticks()
+    local dt = math.min((now - last) / 1000, 0.05)
+    last = now
+    for id, b in pairs(bodies) do
+        b.x = b.x + b.vx * dt
+        b.y = b.y + b.vy * dt
+        if b.x < 0 or b.x > 780 then b.vx = -b.vx end
+        if b.y < 0 or b.y > 580 then b.vy = -b.vy end
+        sdl.world_move(world, id, b.x, b.y)
+    end
+
+    for id in pairs(hit) do hit[id] = nil end
+    local list, count = sdl.world_pairs(world, pairs_out)
+    for i = 1, count * 2 do hit[list[i]] = true end
+
+    sdl.set_render_draw_color(renderer, 20, 20, 30, 255)
+    sdl.render_clear(renderer)
+    for id, b in pairs(bodies) do
+        if hit[id] then
+            sdl.set_render_draw_color(renderer, 255, 80, 80, 255)
+        else
+            sdl.set_render_draw_color(renderer, 120, 200, 255, 255)
+        end
+        if b.circle then
+            sdl.render_fill_circle(renderer, b.x, b.y, b.size)
+        else
+            sdl.render_fill_rect(renderer, b.x, b.y, b.size * 2, b.size * 2)
+        end
+    end
+    sdl.set_render_draw_color(renderer, 255, 255, 255, 255)
+    sdl.render_debug_text(renderer, 10, 10, "overlapping pairs: " .. count)
+    sdl.render_present(renderer)
+end
+
+sdl.destroy_window(window)
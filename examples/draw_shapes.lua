@@ -97,6 +97,26 @@ while true do
     sdl.set_render_draw_color(renderer, 255, 0, 0, 255)
     sdl.render_line(renderer, 100, 100, 700, 500)
 
+    -- Native shapes (tessellated in C, submitted as one geometry batch)
+    sdl.set_render_draw_color(renderer, 255, 128, 0, 255)
+    sdl.render_fill_circle(renderer, 120, 400, 40)
+    sdl.render_circle(renderer, 220, 400, 40, 4)
+    sdl.render_fill_arc(renderer, 320, 400, 40, 0, math.pi * 1.5)
+    sdl.set_render_draw_color(renderer, 0, 200, 200, 255)
+    sdl.render_fill_rounded_rect(renderer, 400, 360, 120, 80, 16)
+    sdl.render_thick_lines(renderer, {
+        {x=560, y=440},
+        {x=600, y=360},
+        {x=640, y=440},
+        {x=680, y=360}
+    }, 6)
+    sdl.render_fill_polygon(renderer, {
+        {x=700, y=300},
+        {x=760, y=320},
+        {x=740, y=380},
+        {x=680, y=360}
+    })
+
     -- Draw debug text
     sdl.set_render_draw_color(renderer, 255, 0, 0, 255) -- Red text
     sdl.render_debug_text(renderer, 50, 50, "Testing SDL3 with Lua!")
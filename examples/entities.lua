@@ -0,0 +1,68 @@
+local sdl = require 'sdl'
+
+math.randomseed(1)
+
+sdl.init(sdl.INIT_VIDEO)
+
+local window = sdl.create_window("SDL3 Entities Demo", 800, 600, sdl.WINDOW_RESIZABLE)
+local window_id = window.windowID
+
+local renderer, err = sdl.create_renderer(window)
+if not renderer then
+    print("Error creating renderer: " .. (err or "Unknown error"))
+    return
+end
+
+print("20000 entities move and bounce in C. ESC to exit.")
+
+local reg = sdl.create_registry()
+for i = 1, 20000 do
+    local e = sdl.create_entity(reg)
+    sdl.entity_set_position(reg, e, math.random(0, 790), math.random(0, 590))
+    sdl.entity_set_velocity(reg, e, math.random(-100, 100), math.random(-100, 100))
+    sdl.entity_set_color(reg, e, math.random(80, 255), math.random(80, 255), math.random(80, 255))
+    sdl.entity_set_sprite(reg, e, 4, 4)
+end
+local moving = sdl.COMPONENT_POSITION | sdl.COMPONENT_VELOCITY
+
+local last = sdl.get_ticks()
+local frame = 0
+
+while true do
+    local events = sdl.poll_events()
+    for i, event in ipairs(events) do
+        if event.type == sdl.QUIT or (event.type == sdl.WINDOW_CLOSE and event.window_id == window_id) then
+            print("Window closed.")
+            return
+        elseif event.type == sdl.KEY_DOWN and event.keycode == sdl.KEY_ESCAPE then
+            print("ESC pressed. Exiting.")
+            return
+        end
+    end
+
+    local now = sdl.get_ticks()
+    local dt = math.min((now - last) / 1000, 0.05)
+    last = now
+    sdl.registry_integrate(reg, dt)
+
+    -- Bounce a slice of the entities from Lua each frame to show queries
+    frame = frame + 1
+    if frame % 10 == 0 then
+        for e in sdl.registry_query(reg, moving) do
+            local x, y = sdl.entity_get_position(reg, e)
+            local vx, vy = sdl.entity_get_velocity(reg, e)
+            if x < 0 or x > 796 then vx = -vx end
+            if y < 0 or y > 596 then vy = -vy end
+            sdl.entity_set_velocity(reg, e, vx, vy)
+        end
+    end
+
+    sdl.set_render_draw_color(renderer, 10, 10, 20, 255)
+    sdl.render_clear(renderer)
+    local drawn = sdl.render_registry(renderer, reg)
+    sdl.set_render_draw_color(renderer, 255, 255, 255, 255)
+    sdl.render_debug_text(renderer, 10, 10, "entities drawn: " .. drawn)
+    sdl.render_present(renderer)
+end
+
+sdl.destroy_window(window)
@@ -0,0 +1,52 @@
+local sdl = require 'sdl'
+
+sdl.init(sdl.INIT_VIDEO)
+
+local window = sdl.create_window("SDL3 Input State Demo", 800, 600, sdl.WINDOW_RESIZABLE)
+local window_id = window.windowID
+
+local renderer, err = sdl.create_renderer(window)
+if not renderer then
+    print("Error creating renderer: " .. (err or "Unknown error"))
+    return
+end
+
+print("WASD moves the box, SPACE changes color, click to teleport. ESC to exit.")
+
+-- Polled state instead of event tables
+local input = sdl.get_input()
+local x, y = 400, 300
+local color = 1
+local colors = {{255, 0, 0}, {0, 255, 0}, {0, 128, 255}}
+
+while true do
+    if sdl.update_input(input, true) then
+        print("Window closed.")
+        return
+    end
+
+    if sdl.key_pressed(input, sdl.SCANCODE_ESCAPE) then
+        print("ESC pressed. Exiting.")
+        return
+    end
+    if input[sdl.SCANCODE_W] then y = y - 4 end
+    if input[sdl.SCANCODE_S] then y = y + 4 end
+    if input[sdl.SCANCODE_A] then x = x - 4 end
+    if input[sdl.SCANCODE_D] then x = x + 4 end
+    if sdl.key_pressed(input, sdl.SCANCODE_SPACE) then
+        color = color % #colors + 1
+    end
+    if sdl.mouse_pressed(input, sdl.BUTTON_LEFT) then
+        x, y = input.x, input.y
+    end
+
+    sdl.set_render_draw_color(renderer, 30, 30, 30, 255)
+    sdl.render_clear(renderer)
+    sdl.set_render_draw_color(renderer, colors[color][1], colors[color][2], colors[color][3], 255)
+    sdl.render_fill_rect(renderer, x - 20, y - 20, 40, 40)
+    sdl.render_present(renderer)
+end
+
+sdl.destroy_window(window)
+window = nil
+sdl.quit()
@@ -0,0 +1,80 @@
+local sdl = require 'sdl'
+
+sdl.init(sdl.INIT_VIDEO)
+
+local window = sdl.create_window("SDL3 Particles Demo", 800, 600, sdl.WINDOW_RESIZABLE)
+local window_id = window.windowID
+
+local renderer, err = sdl.create_renderer(window)
+if not renderer then
+    print("Error creating renderer: " .. (err or "Unknown error"))
+    return
+end
+
+print("Hold the left mouse button to spray particles. ESC to exit.")
+
+local fountain = sdl.create_particles({
+    capacity = 150000,
+    life_min = 1.0, life_max = 2.5,
+    speed_min = 100, speed_max = 350,
+    angle = -math.pi / 2, spread = 0.6,
+    gravity_y = 250,
+    size = 2,
+    start_color = {120, 200, 255, 255},
+    end_color = {20, 40, 255, 0},
+})
+local spray = sdl.create_particles({
+    capacity = 50000,
+    life_min = 0.3, life_max = 0.8,
+    speed_min = 20, speed_max = 200,
+    size = 3,
+    start_color = {255, 220, 80, 255},
+    end_color = {255, 40, 0, 0},
+})
+
+local input = sdl.get_input()
+local last = sdl.get_ticks()
+local report = 0
+
+while true do
+    local events = sdl.poll_events()
+    for _, event in ipairs(events) do
+        if event.type == sdl.QUIT or (event.type == sdl.WINDOW_CLOSE and event.window_id == window_id) then
+            print("Window closed.")
+            return
+        elseif event.type == sdl.KEY_DOWN and event.keycode == sdl.KEY_ESCAPE then
+            print("ESC pressed. Exiting.")
+            return
+        end
+    end
+    sdl.update_input(input)
+
+    local now = sdl.get_ticks()
+    local dt = math.min((now - last) / 1000, 0.05)
+    last = now
+
+    sdl.emit_particles(fountain, 1500, 400, 580)
+    if sdl.mouse_down(input, sdl.BUTTON_LEFT) then
+        sdl.emit_particles(spray, 800, input.x, input.y)
+    end
+    sdl.update_particles(fountain, dt)
+    sdl.update_particles(spray, dt)
+
+    sdl.set_render_draw_color(renderer, 0, 0, 0, 255)
+    sdl.render_clear(renderer)
+    sdl.render_particles(renderer, fountain)
+    sdl.render_particles(renderer, spray)
+    sdl.set_render_draw_color(renderer, 255, 255, 255, 255)
+    sdl.render_debug_text(renderer, 10, 10, string.format("particles: %d",
+        sdl.particle_count(fountain) + sdl.particle_count(spray)))
+    sdl.render_present(renderer)
+
+    report = report + dt
+    if report >= 2 then
+        report = 0
+        local frames, avg_ms = sdl.get_frame_stats()
+        print(string.format("avg frame %.2f ms", avg_ms))
+    end
+end
+
+sdl.destroy_window(window)
@@ -0,0 +1,68 @@
+local sdl = require 'sdl'
+
+math.randomseed(1)
+
+sdl.init(sdl.INIT_VIDEO)
+
+local window = sdl.create_window("SDL3 Scene Culling Demo", 800, 600, sdl.WINDOW_RESIZABLE)
+local window_id = window.windowID
+
+local renderer, err = sdl.create_renderer(window)
+if not renderer then
+    print("Error creating renderer: " .. (err or "Unknown error"))
+    return
+end
+
+print("Arrow keys pan the camera. Press ESC or close to exit.")
+
+-- A large retained scene: only the items inside the view are drawn
+local scene = sdl.create_scene(256)
+for i = 1, 200000 do
+    local x, y = math.random(0, 40000), math.random(0, 40000)
+    local size = math.random(4, 24)
+    local kind = (i % 2 == 0) and sdl.SCENE_RECT or sdl.SCENE_CIRCLE
+    sdl.scene_add(scene, kind, x, y, size, size, math.random(64, 255), math.random(64, 255), math.random(64, 255))
+end
+
+local cam_x, cam_y = 20000, 20000
+local font = sdl.create_font(renderer)
+
+while true do
+    local events = sdl.poll_events()
+    for i, event in ipairs(events) do
+        if event.type == sdl.QUIT or (event.type == sdl.WINDOW_CLOSE and event.window_id == window_id) then
+            print("Window closed.")
+            return
+        elseif event.type == sdl.KEY_DOWN then
+            if event.keycode == sdl.KEY_ESCAPE then
+                print("ESC pressed. Exiting.")
+                return
+            elseif event.key_name == "Left" then
+                cam_x = cam_x - 100
+            elseif event.key_name == "Right" then
+                cam_x = cam_x + 100
+            elseif event.key_name == "Up" then
+                cam_y = cam_y - 100
+            elseif event.key_name == "Down" then
+                cam_y = cam_y + 100
+            end
+        end
+    end
+
+    sdl.set_render_draw_color(renderer, 0, 0, 0, 255)
+    sdl.render_clear(renderer)
+
+    sdl.push_transform(renderer)
+    sdl.translate(renderer, -cam_x, -cam_y)
+    local drawn = sdl.render_scene(renderer, scene)
+    sdl.pop_transform(renderer)
+
+    sdl.set_render_draw_color(renderer, 255, 255, 255, 255)
+    sdl.render_text(renderer, font, 10, 10, string.format("drawn %d of %d", drawn, sdl.scene_count(scene)))
+
+    sdl.render_present(renderer)
+end
+
+sdl.destroy_window(window)
+window = nil
+sdl.quit()
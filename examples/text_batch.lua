@@ -0,0 +1,66 @@
+local sdl = require 'sdl'
+
+sdl.init(sdl.INIT_VIDEO)
+
+local window = sdl.create_window("SDL3 Text Batch Demo", 800, 600, sdl.WINDOW_RESIZABLE)
+local window_id = window.windowID
+
+local renderer, err = sdl.create_renderer(window)
+if not renderer then
+    print("Error creating renderer: " .. (err or "Unknown error"))
+    return
+end
+
+print("Window and renderer created. Press ESC or close to exit.")
+
+-- Glyph atlas built once from the built-in debug font
+local font = sdl.create_font(renderer)
+
+-- Static labels: laid out once, drawn every frame with one geometry call
+local labels = sdl.create_text_batch(font)
+sdl.text_batch_set_color(labels, 200, 200, 255)
+for row = 0, 39 do
+    for col = 0, 7 do
+        sdl.text_batch_add(labels, 10 + col * 98, 40 + row * 14, string.format("cell %d,%d", col, row))
+    end
+end
+
+-- Dynamic HUD: cleared and refilled each frame, unchanged strings hit the layout cache
+local hud = sdl.create_text_batch(font)
+local frame = 0
+
+while true do
+    local events = sdl.poll_events()
+    for i, event in ipairs(events) do
+        if event.type == sdl.QUIT or (event.type == sdl.WINDOW_CLOSE and event.window_id == window_id) then
+            print("Window closed.")
+            return
+        elseif event.type == sdl.KEY_DOWN and event.keycode == sdl.KEY_ESCAPE then
+            print("ESC pressed. Exiting.")
+            return
+        end
+    end
+
+    frame = frame + 1
+
+    sdl.set_render_draw_color(renderer, 30, 30, 30, 255)
+    sdl.render_clear(renderer)
+
+    sdl.render_text_batch(renderer, labels)
+
+    sdl.text_batch_clear(hud)
+    sdl.text_batch_set_color(hud, 255, 255, 0)
+    sdl.text_batch_add(hud, 10, 10, "Text batch demo", 2)
+    sdl.text_batch_add(hud, 300, 10, "frame " .. frame, 2)
+    sdl.render_text_batch(renderer, hud)
+
+    -- Immediate text goes through the renderer batch with the draw color
+    sdl.set_render_draw_color(renderer, 255, 0, 0, 255)
+    sdl.render_text(renderer, font, 10, 590 - 8, "render_text uses the renderer batch")
+
+    sdl.render_present(renderer)
+end
+
+sdl.destroy_window(window)
+window = nil
+sdl.quit()
@@ -0,0 +1,77 @@
+local sdl = require 'sdl'
+
+math.randomseed(1)
+
+sdl.init(sdl.INIT_VIDEO)
+
+local window = sdl.create_window("SDL3 Tilemap Demo", 800, 600, sdl.WINDOW_RESIZABLE)
+local window_id = window.windowID
+
+local renderer, err = sdl.create_renderer(window)
+if not renderer then
+    print("Error creating renderer: " .. (err or "Unknown error"))
+    return
+end
+
+print("Arrow keys scroll a 4096x4096 map, click paints a tile. ESC to exit.")
+
+-- Build a 4x1 atlas of 16x16 tiles in a render target
+local TILE = 16
+local atlas = sdl.create_texture(renderer, sdl.PIXELFORMAT_RGBA8888, sdl.TEXTUREACCESS_TARGET, TILE * 4, TILE)
+local tile_colors = {{40, 120, 40}, {30, 60, 160}, {140, 110, 70}, {200, 200, 200}}
+sdl.set_render_target(renderer, atlas)
+for i, c in ipairs(tile_colors) do
+    sdl.set_render_draw_color(renderer, c[1], c[2], c[3], 255)
+    sdl.render_fill_rect(renderer, (i - 1) * TILE, 0, TILE, TILE)
+    sdl.set_render_draw_color(renderer, 0, 0, 0, 255)
+    sdl.render_rect(renderer, (i - 1) * TILE, 0, TILE, TILE)
+end
+sdl.set_render_target(renderer, nil)
+
+local SIZE = 4096
+local map = sdl.create_tilemap(atlas, SIZE, SIZE, TILE, TILE)
+sdl.tilemap_fill(map, 0, 0, SIZE, SIZE, 1)
+for i = 1, 4000 do
+    local x, y = math.random(0, SIZE - 40), math.random(0, SIZE - 40)
+    sdl.tilemap_fill(map, x, y, math.random(2, 30), math.random(2, 30), math.random(2, 3))
+end
+
+local cam_x, cam_y = SIZE * TILE / 2, SIZE * TILE / 2
+local scroll = {}
+
+while true do
+    local events = sdl.poll_events()
+    for i, event in ipairs(events) do
+        if event.type == sdl.QUIT or (event.type == sdl.WINDOW_CLOSE and event.window_id == window_id) then
+            print("Window closed.")
+            return
+        elseif event.type == sdl.KEY_DOWN then
+            if event.keycode == sdl.KEY_ESCAPE then
+                print("ESC pressed. Exiting.")
+                return
+            end
+            scroll[event.key_name] = true
+        elseif event.type == sdl.KEY_UP then
+            scroll[event.key_name] = nil
+        elseif event.type == sdl.MOUSE_BUTTON_DOWN and event.button == sdl.BUTTON_LEFT then
+            local tx = math.floor((event.x + cam_x) / TILE)
+            local ty = math.floor((event.y + cam_y) / TILE)
+            if tx >= 0 and ty >= 0 and tx < SIZE and ty < SIZE then
+                sdl.tilemap_set(map, tx, ty, 4) -- only this chunk is rebuilt
+            end
+        end
+    end
+    if scroll.Left then cam_x = cam_x - 8 end
+    if scroll.Right then cam_x = cam_x + 8 end
+    if scroll.Up then cam_y = cam_y - 8 end
+    if scroll.Down then cam_y = cam_y + 8 end
+
+    sdl.set_render_draw_color(renderer, 0, 0, 0, 255)
+    sdl.render_clear(renderer)
+    local chunks = sdl.render_tilemap(renderer, map, -cam_x, -cam_y)
+    sdl.set_render_draw_color(renderer, 255, 255, 255, 255)
+    sdl.render_debug_text(renderer, 10, 10, "chunks drawn: " .. chunks)
+    sdl.render_present(renderer)
+end
+
+sdl.destroy_window(window)
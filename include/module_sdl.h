@@ -10,8 +10,38 @@ typedef struct {
     SDL_Window* window;
 } lua_SDL_Window;
 
+// Reusable vertex/index scratch. Shapes append into it and it is submitted
+// with a single SDL_RenderGeometry call (see sdl_batch.c).
+typedef struct {
+    SDL_Vertex* vertices;
+    int* indices;
+    int vertex_count;
+    int vertex_capacity;
+    int index_count;
+    int index_capacity;
+    SDL_Texture* texture; // texture of the pending geometry (NULL = untextured)
+    int transformed;      // vertices before this index already went through the transform
+    SDL_FPoint* points;   // transformed positions for direct draws (geometry buffers, tilemaps)
+    int point_capacity;
+} sdl_batch;
+
+// 2D affine transform: x' = a*x + c*y + tx, y' = b*x + d*y + ty
+typedef struct {
+    float a, b, c, d;
+    float tx, ty;
+} sdl_transform;
+
+#define SDL_TRANSFORM_STACK_MAX 32
+
+typedef struct sdl_capture sdl_capture; // frame capture state (see sdl_capture.c)
+
 typedef struct {
     SDL_Renderer* renderer;
+    sdl_batch batch;
+    sdl_transform transform; // applied to everything drawn through the bindings
+    sdl_transform transform_stack[SDL_TRANSFORM_STACK_MAX];
+    int transform_depth;
+    sdl_capture* capture; // NULL unless start_capture is running
 } lua_SDL_Renderer;
 
 typedef struct {
@@ -26,4 +56,123 @@ void lua_push_SDL_Texture(lua_State* L, SDL_Texture* texture);
 lua_SDL_Texture* lua_check_SDL_Texture(lua_State* L, int idx); 
 int luaopen_sdl(lua_State* L);
 
+// sdl_batch.c
+SDL_Vertex* sdl_batch_alloc(lua_State* L, lua_SDL_Renderer* ud, SDL_Texture* texture,
+                            int num_vertices, int num_indices, int** indices, int* base);
+SDL_FColor sdl_batch_draw_color(lua_SDL_Renderer* ud);
+void sdl_batch_flush(lua_State* L, lua_SDL_Renderer* ud);
+SDL_FPoint* sdl_batch_points(lua_State* L, lua_SDL_Renderer* ud, int count);
+void sdl_batch_free(sdl_batch* batch);
+
+// sdl_transform.c
+void sdl_transform_identity(sdl_transform* t);
+bool sdl_transform_is_identity(const sdl_transform* t);
+float sdl_transform_scale(const sdl_transform* t);
+void sdl_transform_point(const sdl_transform* t, float* x, float* y);
+void sdl_transform_strided(const sdl_transform* t, float* xy, int count, size_t stride);
+void sdl_transform_points(const sdl_transform* t, SDL_FPoint* points, int count);
+void sdl_transform_vertices(const sdl_transform* t, SDL_Vertex* vertices, int count);
+void sdl_batch_apply_transform(lua_SDL_Renderer* ud);
+bool sdl_view_bounds(lua_SDL_Renderer* ud, SDL_FRect* bounds);
+void sdl_transform_register(lua_State* L);
+
+// sdl_grid.c: uniform spatial hash over item ids (scenes, collision)
+typedef struct {
+    int cx, cy;
+    int* items;
+    int count;
+    int capacity;
+    bool occupied;
+} sdl_grid_cell;
+
+typedef struct {
+    float cell_size;
+    float inv_cell;
+    sdl_grid_cell* cells; // open addressing, power of two capacity
+    int capacity;
+    int used;
+} sdl_grid;
+
+typedef void (*sdl_grid_visit)(int id, void* ctx);
+
+void sdl_grid_init(sdl_grid* grid, float cell_size);
+void sdl_grid_free(sdl_grid* grid);
+void sdl_grid_cell_range(const sdl_grid* grid, const SDL_FRect* box, int range[4]);
+bool sdl_grid_box_valid(const sdl_grid* grid, const SDL_FRect* box);
+bool sdl_grid_insert(sdl_grid* grid, int id, const SDL_FRect* box);
+void sdl_grid_remove(sdl_grid* grid, int id, const SDL_FRect* box);
+bool sdl_grid_move(sdl_grid* grid, int id, const SDL_FRect* old_box, const SDL_FRect* new_box);
+void sdl_grid_query(const sdl_grid* grid, const SDL_FRect* box, sdl_grid_visit fn, void* ctx);
+
+// sdl_shapes.c
+void sdl_shape_fill_circle(lua_State* L, lua_SDL_Renderer* ud, float cx, float cy, float radius, SDL_FColor color);
+void sdl_shape_fill_quad(lua_State* L, lua_SDL_Renderer* ud, const SDL_FRect* rect, SDL_FColor color);
+void sdl_shapes_register(lua_State* L);
+
+// sdl_scene.c
+void sdl_scene_register(lua_State* L);
+
+// sdl_input.c
+void sdl_input_apply_event(const SDL_Event* e);
+void sdl_input_register(lua_State* L);
+
+// sdl_capture.c
+void sdl_capture_frame(lua_SDL_Renderer* ud);
+void sdl_capture_stop(lua_SDL_Renderer* ud);
+void sdl_capture_golden(lua_SDL_Renderer* ud);
+void sdl_capture_set_golden(const char* path, int tolerance, bool update);
+bool sdl_capture_golden_failed(void);
+bool sdl_capture_golden_missing(void);
+void sdl_capture_register(lua_State* L);
+
+// sdl_geometry.c
+bool sdl_render_indexed(lua_State* L, int idx, SDL_Renderer* renderer, SDL_Texture* texture,
+                        const SDL_Vertex* vertices, int num_vertices);
+void sdl_geometry_register(lua_State* L);
+
+// sdl_particles.c
+void sdl_particles_register(lua_State* L);
+
+// sdl_tilemap.c
+void sdl_tilemap_register(lua_State* L);
+
+// sdl_registry.c
+void sdl_registry_register(lua_State* L);
+
+// sdl_collision.c
+void sdl_collision_register(lua_State* L);
+
+// sdl_reload.c
+int sdl_reload_loadfile(lua_State* L, const char* path);
+void sdl_reload_poll(lua_State* L);
+void sdl_reload_watch(bool enabled);
+void sdl_reload_set_main(const char* path);
+bool sdl_reload_restart_requested(void);
+bool sdl_reload_wait(lua_State* L);
+void sdl_reload_register(lua_State* L);
+
+// sdl_audio.c
+void sdl_audio_close(void);
+void sdl_audio_register(lua_State* L);
+
+// sdl_replay.c
+bool sdl_replay_record(const char* path);
+bool sdl_replay_play(const char* path);
+bool sdl_replay_active(void);
+void sdl_replay_close(void);
+void sdl_replay_set_fixed_clock(Uint64 dt_ns);
+bool sdl_replay_begin_pump(void);
+bool sdl_replay_accept_event(SDL_Event* e);
+bool sdl_replay_last_frame(void);
+void sdl_replay_end_frame(void);
+void sdl_replay_set_frame_limit(Uint32 frames);
+int sdl_replay_stop_script(lua_State* L);
+bool sdl_replay_frame_limit_hit(void);
+void sdl_replay_frame_stats(Uint32* count, double* avg_ms, double* min_ms, double* max_ms);
+Uint64 sdl_replay_ticks_ns(void);
+void sdl_replay_register(lua_State* L);
+
+// sdl_text.c
+void sdl_text_register(lua_State* L);
+
 #endif
\ No newline at end of file
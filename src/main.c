@@ -2,13 +2,35 @@
 #include <lualib.h>
 #include <lauxlib.h>
 #include <SDL3/SDL.h>
+#include "module_sdl.h" // luaopen_sdl and the host hooks (replay, capture, reload, audio)
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <errno.h>
 
-// Declare the sdl module's entry point (from module_sdl.c).
-int luaopen_sdl(lua_State* L);
+// Exit code for a --golden run without a reference image (ctest SKIP_RETURN_CODE)
+#define GOLDEN_SKIP_EXIT 77
+
+static void print_usage(const char* program) {
+    fprintf(stderr, "Usage: %s [options] [<lua_script_path>]\n", program);
+    fprintf(stderr, "  --record <file>   record input events to file\n");
+    fprintf(stderr, "  --replay <file>   replay input events from file\n");
+    fprintf(stderr, "  --fixed-dt <ms>   advance sdl.get_ticks() by ms per presented frame\n");
+    fprintf(stderr, "  --headless        use the offscreen video, software render and dummy audio drivers\n");
+    fprintf(stderr, "  --frames <n>      stop after n presented frames and print frame times\n");
+    fprintf(stderr, "  --golden <bmp>    compare the last frame with bmp (exit code 77 if bmp is missing)\n");
+    fprintf(stderr, "  --update-golden   write the last frame to the --golden bmp instead of comparing\n");
+    fprintf(stderr, "  --tolerance <n>   allowed per-channel difference for --golden (default 0)\n");
+    fprintf(stderr, "  --watch           reload changed scripts and modules without restarting SDL\n");
+}
+
+// Report the frame times of a --frames run on stdout, one line per script.
+static void print_frame_stats(const char* script_path) {
+    Uint32 count;
+    double avg_ms, min_ms, max_ms;
+    sdl_replay_frame_stats(&count, &avg_ms, &min_ms, &max_ms);
+    printf("%s: frames=%u avg_ms=%.3f min_ms=%.3f max_ms=%.3f\n", script_path, count, avg_ms, min_ms, max_ms);
+}
 
 // Check if a file exists.
 static int file_exists(const char* path) {
@@ -37,35 +59,143 @@ int main(int argc, char* argv[]) {
 
     // SDL_CreateWindowAndRenderer
 
-    // Determine script path: command-line arg or default to "main.lua".
-    const char* script_path = (argc >= 2) ? argv[1] : "main.lua";
+    // Parse options; the first non-option argument is the script.
+    const char* script_path = NULL;
+    const char* record_path = NULL;
+    const char* replay_path = NULL;
+    const char* golden_path = NULL;
+    int tolerance = 0;
+    int frames = 0;
+    bool update_golden = false;
+    bool watch = false;
+    for (int i = 1; i < argc; i++) {
+        bool has_value = i + 1 < argc;
+        if (strcmp(argv[i], "--record") == 0 && has_value) {
+            record_path = argv[++i];
+        } else if (strcmp(argv[i], "--replay") == 0 && has_value) {
+            replay_path = argv[++i];
+        } else if (strcmp(argv[i], "--fixed-dt") == 0 && has_value) {
+            double ms = atof(argv[++i]);
+            sdl_replay_set_fixed_clock(ms > 0 ? (Uint64)(ms * SDL_NS_PER_MS) : 0);
+        } else if (strcmp(argv[i], "--headless") == 0) {
+            SDL_SetHint(SDL_HINT_VIDEO_DRIVER, "offscreen");
+            SDL_SetHint(SDL_HINT_RENDER_DRIVER, "software");
+            SDL_SetHint(SDL_HINT_AUDIO_DRIVER, "dummy");
+        } else if (strcmp(argv[i], "--frames") == 0 && has_value) {
+            frames = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--golden") == 0 && has_value) {
+            golden_path = argv[++i];
+        } else if (strcmp(argv[i], "--tolerance") == 0 && has_value) {
+            tolerance = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--update-golden") == 0) {
+            update_golden = true;
+        } else if (strcmp(argv[i], "--watch") == 0) {
+            watch = true;
+        } else if (strncmp(argv[i], "--", 2) == 0) {
+            fprintf(stderr, "Error: Unknown or incomplete option '%s'\n", argv[i]);
+            print_usage(argv[0]);
+            lua_close(L);
+            return 1;
+        } else if (!script_path) {
+            script_path = argv[i];
+        }
+    }
+    bool default_script = script_path == NULL;
+    if (default_script) {
+        script_path = "main.lua"; // default
+    }
 
     // Check if the script file exists.
     if (!file_exists(script_path)) {
         fprintf(stderr, "Error: Script '%s' not found\n", script_path);
-        if (argc < 2) {
-            fprintf(stderr, "Usage: %s [<lua_script_path>]\n", argv[0]);
+        if (default_script) {
+            print_usage(argv[0]);
         }
         lua_close(L);
         return 1;
     }
 
-    // Load and run the Lua script.
-    if (luaL_loadfile(L, script_path) != LUA_OK) {
-        fprintf(stderr, "Error loading script '%s': %s\n", script_path, lua_tostring(L, -1));
+    if (update_golden && !golden_path) {
+        fprintf(stderr, "Error: --update-golden needs --golden <bmp>\n");
         lua_close(L);
         return 1;
     }
+    if (golden_path && frames <= 0) {
+        fprintf(stderr, "Error: --golden needs --frames <n>\n");
+        lua_close(L);
+        return 1;
+    }
+    if (frames > 0) {
+        sdl_replay_set_frame_limit((Uint32)frames);
+        sdl_capture_set_golden(golden_path, tolerance, update_golden);
+    }
 
-    // Execute the script.
-    if (lua_pcall(L, 0, 0, 0) != LUA_OK) {
-        fprintf(stderr, "Error running script '%s': %s\n", script_path, lua_tostring(L, -1));
+    if (record_path && replay_path) {
+        fprintf(stderr, "Error: --record and --replay cannot be combined\n");
         lua_close(L);
         return 1;
     }
+    if (record_path && !sdl_replay_record(record_path)) {
+        fprintf(stderr, "Error: Cannot record to '%s': %s\n", record_path, SDL_GetError());
+        lua_close(L);
+        return 1;
+    }
+    if (replay_path && !sdl_replay_play(replay_path)) {
+        fprintf(stderr, "Error: Cannot replay '%s': %s\n", replay_path, SDL_GetError());
+        lua_close(L);
+        return 1;
+    }
+
+    if (watch) {
+        sdl_reload_watch(true);
+        sdl_reload_set_main(script_path);
+    }
+
+    // Load and run the Lua script. Reaching the --frames limit unwinds it with an
+    // error; with --watch a change to the script unwinds it to be run again, and
+    // a failing script waits for the next change instead of exiting.
+    for (;;) {
+        bool loaded = sdl_reload_loadfile(L, script_path) == LUA_OK;
+        if (loaded && lua_pcall(L, 0, 0, 0) == LUA_OK) {
+            break;
+        }
+        if (sdl_replay_frame_limit_hit()) {
+            break;
+        }
+        if (sdl_reload_restart_requested()) {
+            lua_pop(L, 1);
+            printf("Reloading '%s'\n", script_path);
+            continue;
+        }
+        fprintf(stderr, "Error %s script '%s': %s\n", loaded ? "running" : "loading", script_path, lua_tostring(L, -1));
+        lua_pop(L, 1);
+        if (!watch) {
+            sdl_replay_close();
+            lua_close(L);
+            return 1;
+        }
+        fprintf(stderr, "Waiting for changes to '%s'...\n", script_path);
+        if (!sdl_reload_wait(L)) {
+            break;
+        }
+    }
+
+    int status = 0;
+    if (frames > 0) {
+        print_frame_stats(script_path);
+        if (golden_path && sdl_capture_golden_missing()) {
+            fprintf(stderr, "Golden image check skipped for '%s': no reference\n", script_path);
+            status = GOLDEN_SKIP_EXIT;
+        } else if (golden_path && sdl_capture_golden_failed()) {
+            fprintf(stderr, "Golden image check failed for '%s'\n", script_path);
+            status = 1;
+        }
+    }
 
     // Clean up.
+    sdl_replay_close(); // finish a recording even if the script never called sdl.quit
+    sdl_audio_close();  // stop the mixer before sounds are collected
     lua_close(L);
     SDL_Quit(); // Ensure SDL is cleaned up after script execution.
-    return 0;
+    return status;
 }
\ No newline at end of file
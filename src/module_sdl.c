@@ -143,6 +143,8 @@ static int window_gc(lua_State* L) {
 // GC metamethod for renderer: Destroy the SDL_Renderer.
 static int renderer_gc(lua_State* L) {
     lua_SDL_Renderer* ud = lua_check_SDL_Renderer(L, 1);
+    sdl_capture_stop(ud);
+    sdl_batch_free(&ud->batch);
     if (ud->renderer) {
         SDL_DestroyRenderer(ud->renderer);
         ud->renderer = NULL;
@@ -209,6 +211,7 @@ static int l_sdl_render_clear(lua_State* L) {
     if (!ud->renderer) {
         luaL_error(L, "No renderer available");
     }
+    sdl_batch_flush(L, ud);
 
     if (!SDL_RenderClear(ud->renderer)) {
         luaL_error(L, "Failed to clear renderer: %s", SDL_GetError());
@@ -223,8 +226,25 @@ static int l_sdl_render_present(lua_State* L) {
     if (!ud->renderer) {
         luaL_error(L, "No renderer available");
     }
+    sdl_batch_flush(L, ud);
+    sdl_capture_frame(ud); // the back buffer is undefined after presenting
+    bool last_frame = sdl_replay_last_frame();
+    if (last_frame) {
+        sdl_capture_golden(ud);
+    }
 
     SDL_RenderPresent(ud->renderer);
+    sdl_replay_end_frame();
+    if (last_frame) {
+        return sdl_replay_stop_script(L);
+    }
+    return 0;
+}
+
+// Submit batched shapes now: sdl.render_flush(renderer)
+static int l_sdl_render_flush(lua_State* L) {
+    lua_SDL_Renderer* ud = lua_check_SDL_Renderer(L, 1);
+    sdl_batch_flush(L, ud);
     return 0;
 }
 
@@ -261,7 +281,9 @@ void lua_push_SDL_Renderer(lua_State* L, SDL_Renderer* renderer) {
         luaL_error(L, "Cannot create userdata for null SDL_Renderer");
     }
     lua_SDL_Renderer* ud = (lua_SDL_Renderer*)lua_newuserdata(L, sizeof(lua_SDL_Renderer));
+    memset(ud, 0, sizeof(lua_SDL_Renderer));
     ud->renderer = renderer;
+    sdl_transform_identity(&ud->transform);
     luaL_setmetatable(L, RENDERER_MT);
 }
 
@@ -423,6 +445,9 @@ static int l_sdl_render_line(lua_State* L) {
     if (!ud->renderer) {
         luaL_error(L, "No renderer available");
     }
+    sdl_batch_flush(L, ud);
+    sdl_transform_point(&ud->transform, &x1, &y1);
+    sdl_transform_point(&ud->transform, &x2, &y2);
 
     if (!SDL_RenderLine(ud->renderer, x1, y1, x2, y2)) {
         luaL_error(L, "Failed to draw line: %s", SDL_GetError());
@@ -441,6 +466,8 @@ static int l_sdl_render_debug_text(lua_State* L) {
     if (!ud->renderer) {
         luaL_error(L, "No renderer available");
     }
+    sdl_batch_flush(L, ud);
+    sdl_transform_point(&ud->transform, &x, &y); // only the origin moves, glyphs stay 8x8
 
     if (!SDL_RenderDebugText(ud->renderer, x, y, text)) {
         luaL_error(L, "Failed to render debug text: %s", SDL_GetError());
@@ -451,11 +478,19 @@ static int l_sdl_render_debug_text(lua_State* L) {
 
 // sdl.poll_events(): Return a table of events.
 static int l_sdl_poll_events(lua_State* L) {
+    sdl_reload_poll(L);
     lua_newtable(L);
     int event_count = 0;
 
+    if (!sdl_replay_begin_pump()) {
+        luaL_error(L, "Failed to push replayed events: %s", SDL_GetError());
+    }
+
     SDL_Event e;
     while (SDL_PollEvent(&e)) {
+        if (!sdl_replay_accept_event(&e)) {
+            continue; // live input during replay
+        }
         push_event_table(L, &e);
         if (lua_isnil(L, -1)) {
             lua_pop(L, 1);
@@ -476,6 +511,8 @@ static int l_sdl_render_point(lua_State* L) {
     if (!ud->renderer) {
         luaL_error(L, "No renderer available");
     }
+    sdl_batch_flush(L, ud);
+    sdl_transform_point(&ud->transform, &x, &y);
 
     if (!SDL_RenderPoint(ud->renderer, x, y)) {
         luaL_error(L, "Failed to draw point: %s", SDL_GetError());
@@ -491,6 +528,7 @@ static int l_sdl_render_points(lua_State* L) {
     if (!ud->renderer) {
         luaL_error(L, "No renderer available");
     }
+    sdl_batch_flush(L, ud);
 
     // Expect a table of points [{x1, y1}, {x2, y2}, ...]
     luaL_checktype(L, 2, LUA_TTABLE);
@@ -520,6 +558,8 @@ static int l_sdl_render_points(lua_State* L) {
         lua_pop(L, 1); // Pop the point table
     }
 
+    sdl_transform_points(&ud->transform, points, count);
+
     if (!SDL_RenderPoints(ud->renderer, points, count)) {
         free(points);
         luaL_error(L, "Failed to draw points: %s", SDL_GetError());
@@ -529,6 +569,23 @@ static int l_sdl_render_points(lua_State* L) {
     return 0;
 }
 
+// Apply an axis aligned transform to a rect. Returns false if the transform
+// rotates or shears, in which case the rect is left untouched.
+static bool transform_rect(const sdl_transform* t, SDL_FRect* rect) {
+    if (t->b != 0.0f || t->c != 0.0f) {
+        return false;
+    }
+    float x0 = rect->x, y0 = rect->y;
+    float x1 = rect->x + rect->w, y1 = rect->y + rect->h;
+    sdl_transform_point(t, &x0, &y0);
+    sdl_transform_point(t, &x1, &y1);
+    rect->x = x0 < x1 ? x0 : x1;
+    rect->y = y0 < y1 ? y0 : y1;
+    rect->w = SDL_fabsf(x1 - x0);
+    rect->h = SDL_fabsf(y1 - y0);
+    return true;
+}
+
 // Draw a rectangle outline: sdl.render_rect(renderer, x, y, w, h)
 static int l_sdl_render_rect(lua_State* L) {
     lua_SDL_Renderer* ud = lua_check_SDL_Renderer(L, 1);
@@ -540,8 +597,18 @@ static int l_sdl_render_rect(lua_State* L) {
     if (!ud->renderer) {
         luaL_error(L, "No renderer available");
     }
+    sdl_batch_flush(L, ud);
 
     SDL_FRect rect = { x, y, w, h };
+    if (!transform_rect(&ud->transform, &rect)) {
+        // Rotated or sheared: draw the outline as a closed polyline
+        SDL_FPoint corners[5] = { {x, y}, {x + w, y}, {x + w, y + h}, {x, y + h}, {x, y} };
+        sdl_transform_points(&ud->transform, corners, 5);
+        if (!SDL_RenderLines(ud->renderer, corners, 5)) {
+            luaL_error(L, "Failed to draw rectangle: %s", SDL_GetError());
+        }
+        return 0;
+    }
     if (!SDL_RenderRect(ud->renderer, &rect)) {
         luaL_error(L, "Failed to draw rectangle: %s", SDL_GetError());
     }
@@ -560,8 +627,15 @@ static int l_sdl_render_fill_rect(lua_State* L) {
     if (!ud->renderer) {
         luaL_error(L, "No renderer available");
     }
+    sdl_batch_flush(L, ud);
 
     SDL_FRect rect = { x, y, w, h };
+    if (!transform_rect(&ud->transform, &rect)) {
+        // Rotated or sheared: draw a quad through the batch instead
+        sdl_shape_fill_quad(L, ud, &rect, sdl_batch_draw_color(ud));
+        sdl_batch_flush(L, ud);
+        return 0;
+    }
     if (!SDL_RenderFillRect(ud->renderer, &rect)) {
         luaL_error(L, "Failed to draw filled rectangle: %s", SDL_GetError());
     }
@@ -576,6 +650,7 @@ static int l_sdl_render_lines(lua_State* L) {
     if (!ud->renderer) {
         luaL_error(L, "No renderer available");
     }
+    sdl_batch_flush(L, ud);
 
     // Expect a table of points [{x1, y1}, {x2, y2}, ...]
     luaL_checktype(L, 2, LUA_TTABLE);
@@ -605,6 +680,8 @@ static int l_sdl_render_lines(lua_State* L) {
         lua_pop(L, 1); // Pop the point table
     }
 
+    sdl_transform_points(&ud->transform, points, count);
+
     if (!SDL_RenderLines(ud->renderer, points, count)) {
         free(points);
         luaL_error(L, "Failed to draw lines: %s", SDL_GetError());
@@ -635,6 +712,25 @@ static int l_sdl_create_texture(lua_State* L) {
     return 1;
 }
 
+// Set render target: sdl.set_render_target(renderer, texture) (nil renders to the window)
+static int l_sdl_set_render_target(lua_State* L) {
+    lua_SDL_Renderer* ud = lua_check_SDL_Renderer(L, 1);
+    SDL_Texture* texture = NULL;
+    if (!lua_isnoneornil(L, 2)) {
+        texture = lua_check_SDL_Texture(L, 2)->texture;
+    }
+
+    if (!ud->renderer) {
+        luaL_error(L, "No renderer available");
+    }
+    sdl_batch_flush(L, ud);
+
+    if (!SDL_SetRenderTarget(ud->renderer, texture)) {
+        luaL_error(L, "Failed to set render target: %s", SDL_GetError());
+    }
+    return 0;
+}
+
 // Render geometry: sdl.render_geometry(renderer, texture, vertices, indices)
 static int l_sdl_render_geometry(lua_State* L) {
     lua_SDL_Renderer* ud = lua_check_SDL_Renderer(L, 1);
@@ -647,6 +743,7 @@ static int l_sdl_render_geometry(lua_State* L) {
     if (!ud->renderer) {
         luaL_error(L, "No renderer available");
     }
+    sdl_batch_flush(L, ud);
 
     // Expect a table of vertices [{x, y, r, g, b, a, u, v}, ...]
     luaL_checktype(L, 3, LUA_TTABLE);
@@ -655,10 +752,9 @@ static int l_sdl_render_geometry(lua_State* L) {
         return 0; // No vertices to draw
     }
 
-    SDL_Vertex* vertices = (SDL_Vertex*)malloc(num_vertices * sizeof(SDL_Vertex));
-    if (!vertices) {
-        luaL_error(L, "Failed to allocate memory for vertices");
-    }
+    // Userdata on the stack rather than malloc: the checks below (and in
+    // sdl_render_indexed) raise errors, and the GC then frees it.
+    SDL_Vertex* vertices = (SDL_Vertex*)lua_newuserdata(L, (size_t)num_vertices * sizeof(SDL_Vertex));
 
     // Iterate over the vertices table
     for (int i = 1; i <= num_vertices; i++) {
@@ -700,6 +796,16 @@ static int l_sdl_render_geometry(lua_State* L) {
         lua_pop(L, 1); // Pop the vertex table
     }
 
+    sdl_transform_vertices(&ud->transform, vertices, num_vertices);
+
+    // An index buffer from sdl.create_index_buffer is passed through as is
+    if (lua_isuserdata(L, 4)) {
+        if (!sdl_render_indexed(L, 4, ud->renderer, texture, vertices, num_vertices)) {
+            luaL_error(L, "Failed to render geometry: %s", SDL_GetError());
+        }
+        return 0;
+    }
+
     // Handle indices (optional)
     int* indices = NULL;
     int num_indices = 0;
@@ -707,12 +813,7 @@ static int l_sdl_render_geometry(lua_State* L) {
         luaL_checktype(L, 4, LUA_TTABLE);
         num_indices = lua_rawlen(L, 4);
         if (num_indices > 0) {
-            indices = (int*)malloc(num_indices * sizeof(int));
-            if (!indices) {
-                free(vertices);
-                luaL_error(L, "Failed to allocate memory for indices");
-            }
-
+            indices = (int*)lua_newuserdata(L, (size_t)num_indices * sizeof(int));
             for (int i = 1; i <= num_indices; i++) {
                 lua_rawgeti(L, 4, i);
                 indices[i-1] = luaL_checkinteger(L, -1) - 1; // Lua indices are 1-based, SDL expects 0-based
@@ -722,13 +823,8 @@ static int l_sdl_render_geometry(lua_State* L) {
     }
 
     if (!SDL_RenderGeometry(ud->renderer, texture, vertices, num_vertices, indices, num_indices)) {
-        free(vertices);
-        if (indices) free(indices);
         luaL_error(L, "Failed to render geometry: %s", SDL_GetError());
     }
-
-    free(vertices);
-    if (indices) free(indices);
     return 0;
 }
 
@@ -745,6 +841,8 @@ static int l_sdl_destroy_window(lua_State* L) {
 
 // SDL Quit: sdl.quit()
 static int l_sdl_quit(lua_State* L) {
+    sdl_replay_close();
+    sdl_audio_close();
     SDL_Quit();
     fprintf(stderr, "[SDL] Called SDL_Quit\n");
     return 0;
@@ -763,6 +861,7 @@ static const struct luaL_Reg sdl_lib[] = {
     {"set_render_draw_color", l_sdl_set_render_draw_color},
     {"render_clear", l_sdl_render_clear},
     {"render_present", l_sdl_render_present},
+    {"render_flush", l_sdl_render_flush},
     {"render_line", l_sdl_render_line},           
     {"render_debug_text", l_sdl_render_debug_text},
     {"render_point", l_sdl_render_point},         
@@ -771,6 +870,7 @@ static const struct luaL_Reg sdl_lib[] = {
     {"render_fill_rect", l_sdl_render_fill_rect}, 
     {"render_lines", l_sdl_render_lines},
     {"create_texture", l_sdl_create_texture},
+    {"set_render_target", l_sdl_set_render_target},
     {"render_geometry", l_sdl_render_geometry},
     {"destroy_window", l_sdl_destroy_window},
     {"quit", l_sdl_quit}, 
@@ -785,6 +885,20 @@ int luaopen_sdl(lua_State* L) {
     renderer_metatable(L);
     texture_metatable(L);
     luaL_newlib(L, sdl_lib);
+    sdl_shapes_register(L);
+    sdl_text_register(L);
+    sdl_transform_register(L);
+    sdl_scene_register(L);
+    sdl_input_register(L);
+    sdl_replay_register(L);
+    sdl_capture_register(L);
+    sdl_geometry_register(L);
+    sdl_particles_register(L);
+    sdl_tilemap_register(L);
+    sdl_registry_register(L);
+    sdl_collision_register(L);
+    sdl_reload_register(L);
+    sdl_audio_register(L);
     
     // WINDOW FLAGS
     lua_pushinteger(L, SDL_WINDOW_FULLSCREEN);
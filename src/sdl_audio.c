@@ -0,0 +1,969 @@
+// sdl_audio.c
+// Software audio mixer. SDL_OpenAudioDeviceStream calls the mixer on SDL's
+// audio thread whenever the device needs data; the mixer sums every active
+// voice into a float stereo buffer, four samples at a time when a voice plays
+// at the output rate and with linear interpolation otherwise, and pushes the
+// result into the SDL_AudioStream, which converts to the device format.
+//
+// Sounds are decoded once to float stereo at their own rate. Sound streams
+// decode a WAV file (or WAV bytes from an asset pack) on a loader thread into
+// a small ring per stream, so long music never sits fully in memory and the
+// audio thread never touches the disk. Voices and rings are guarded by the
+// SDL_AudioStream lock, which SDL already holds while the mixer runs.
+#include "module_sdl.h"
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define SDL_AUDIO_SSE2 1
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define SDL_AUDIO_NEON 1
+#endif
+
+static const char* SOUND_MT = "sdl.sound";
+static const char* SOUND_STREAM_MT = "sdl.sound_stream";
+
+#define MIXER_CHANNELS 2      // the mixer is always float stereo
+#define MIXER_MAX_VOICES 256
+#define MIXER_CHUNK_FRAMES 1024
+#define STREAM_DEFAULT_FRAMES 16384 // ring size per sound stream
+#define STREAM_READ_FRAMES 4096     // frames decoded per loader step
+#define STREAM_MAX_FRAME_BYTES 64   // 8 channels of 64-bit samples at most
+#define POS_ONE ((Uint64)1 << 32)   // voice positions are 32.32 fixed point frames
+#define WAV_MAX_RATE 384000         // highest streamed WAV rate, as SDL's own WAV loader
+
+typedef struct {
+    float* data; // interleaved stereo at `freq`, allocated by SDL
+    Uint32 frames;
+    int freq;
+} lua_SDL_Sound;
+
+typedef struct {
+    SDL_IOStream* io;
+    SDL_AudioSpec spec; // format of the PCM data in the file
+    int frame_bytes;
+    Sint64 data_start, data_size, data_read; // PCM bytes in the file
+    float* ring;     // stereo frames
+    Uint32 capacity; // power of two
+    Uint64 write_frame, read_frame; // absolute frames decoded / consumed
+    bool eof;        // everything was decoded and loop is off
+    bool loop;
+    bool listed;     // in the loader's stream list
+    int voice;       // voice playing the stream, -1 if none
+} lua_SDL_SoundStream;
+
+typedef struct {
+    lua_SDL_Sound* sound; // exactly one of sound/stream is set while active
+    lua_SDL_SoundStream* stream;
+    Uint64 pos;  // 32.32 source frame; absolute within the stream for streams
+    Uint64 step; // 32.32 source frames per output frame
+    float volume, pan;
+    bool loop;
+    bool active;
+    Uint32 gen; // bumped on every play so stale handles miss
+} mixer_voice;
+
+static struct {
+    SDL_AudioStream* stream;
+    int freq;
+    float master;
+    mixer_voice voices[MIXER_MAX_VOICES];
+    float mix[MIXER_CHUNK_FRAMES * MIXER_CHANNELS];
+
+    // Stream loader thread; `mutex` guards the list and the streams' files
+    lua_SDL_SoundStream** streams;
+    int stream_count, stream_capacity;
+    SDL_Thread* thread;
+    SDL_Mutex* mutex;
+    SDL_Condition* cond;
+    bool quit;
+
+    // Statistics, updated under the audio stream lock
+    Uint64 buffers, frames, mix_ticks, max_ticks;
+    Uint32 underruns;
+    int playing;
+} mixer = { 0 };
+
+// out += src * (gl, gr) over interleaved stereo frames.
+static void mix_add(float* out, const float* src, int frames, float gl, float gr) {
+    int count = frames * MIXER_CHANNELS;
+    int i = 0;
+#if defined(SDL_AUDIO_SSE2)
+    __m128 g = _mm_setr_ps(gl, gr, gl, gr);
+    for (; i + 4 <= count; i += 4) {
+        _mm_storeu_ps(out + i, _mm_add_ps(_mm_loadu_ps(out + i), _mm_mul_ps(_mm_loadu_ps(src + i), g)));
+    }
+#elif defined(SDL_AUDIO_NEON)
+    const float gains[4] = { gl, gr, gl, gr };
+    float32x4_t g = vld1q_f32(gains);
+    for (; i + 4 <= count; i += 4) {
+        vst1q_f32(out + i, vmlaq_f32(vld1q_f32(out + i), vld1q_f32(src + i), g));
+    }
+#endif
+    for (; i < count; i += 2) {
+        out[i] += src[i] * gl;
+        out[i + 1] += src[i + 1] * gr;
+    }
+}
+
+// Apply the master volume and clamp to [-1, 1].
+static void mix_finish(float* out, int count, float gain) {
+    int i = 0;
+#if defined(SDL_AUDIO_SSE2)
+    __m128 g = _mm_set1_ps(gain), lo = _mm_set1_ps(-1.0f), hi = _mm_set1_ps(1.0f);
+    for (; i + 4 <= count; i += 4) {
+        _mm_storeu_ps(out + i, _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_loadu_ps(out + i), g), lo), hi));
+    }
+#elif defined(SDL_AUDIO_NEON)
+    float32x4_t g = vdupq_n_f32(gain), lo = vdupq_n_f32(-1.0f), hi = vdupq_n_f32(1.0f);
+    for (; i + 4 <= count; i += 4) {
+        vst1q_f32(out + i, vminq_f32(vmaxq_f32(vmulq_f32(vld1q_f32(out + i), g), lo), hi));
+    }
+#endif
+    for (; i < count; i++) {
+        out[i] = SDL_clamp(out[i] * gain, -1.0f, 1.0f);
+    }
+}
+
+static void voice_stop(mixer_voice* v) {
+    if (v->stream) {
+        v->stream->voice = -1;
+    }
+    v->sound = NULL;
+    v->stream = NULL;
+    v->active = false;
+}
+
+// Mix a voice playing a decoded sound into out.
+static void mix_sound_voice(mixer_voice* v, float* out, int frames, float gl, float gr) {
+    const lua_SDL_Sound* s = v->sound;
+    Uint64 end = (Uint64)s->frames << 32;
+    while (frames > 0) {
+        if (v->pos >= end) {
+            if (!v->loop || s->frames == 0) {
+                voice_stop(v);
+                return;
+            }
+            v->pos -= end;
+        }
+        if (v->step == POS_ONE && (v->pos & 0xFFFFFFFFu) == 0) {
+            // Output rate: contiguous vectorized span
+            Uint32 i = (Uint32)(v->pos >> 32);
+            int span = (int)SDL_min((Uint32)frames, s->frames - i);
+            mix_add(out, s->data + (size_t)i * MIXER_CHANNELS, span, gl, gr);
+            out += span * MIXER_CHANNELS;
+            frames -= span;
+            v->pos += (Uint64)span << 32;
+            continue;
+        }
+        // Linear resampling up to the end of the sound
+        while (frames > 0 && v->pos < end) {
+            Uint32 i = (Uint32)(v->pos >> 32);
+            Uint32 j = i + 1 < s->frames ? i + 1 : (v->loop ? 0 : i);
+            float t = (float)(v->pos & 0xFFFFFFFFu) * (1.0f / 4294967296.0f);
+            const float* a = s->data + (size_t)i * MIXER_CHANNELS;
+            const float* b = s->data + (size_t)j * MIXER_CHANNELS;
+            out[0] += (a[0] + (b[0] - a[0]) * t) * gl;
+            out[1] += (a[1] + (b[1] - a[1]) * t) * gr;
+            out += MIXER_CHANNELS;
+            frames--;
+            v->pos += v->step;
+        }
+    }
+}
+
+// Mix a voice playing a sound stream; stops short and counts an underrun when
+// the loader has not caught up.
+static void mix_stream_voice(mixer_voice* v, float* out, int frames, float gl, float gr) {
+    lua_SDL_SoundStream* s = v->stream;
+    Uint32 mask = s->capacity - 1;
+    while (frames > 0) {
+        Uint64 i = v->pos >> 32;
+        if (i >= s->write_frame) {
+            if (s->eof) {
+                s->read_frame = s->write_frame;
+                voice_stop(v);
+            } else {
+                mixer.underruns++;
+            }
+            return;
+        }
+        if (v->step == POS_ONE && (v->pos & 0xFFFFFFFFu) == 0) {
+            Uint32 r = (Uint32)(i & mask);
+            Uint64 span = SDL_min((Uint64)frames, s->write_frame - i);
+            span = SDL_min(span, (Uint64)(s->capacity - r)); // up to the ring wrap
+            mix_add(out, s->ring + (size_t)r * MIXER_CHANNELS, (int)span, gl, gr);
+            out += span * MIXER_CHANNELS;
+            frames -= (int)span;
+            v->pos += span << 32;
+        } else {
+            // The next frame is needed to interpolate unless the stream ended
+            if (i + 1 >= s->write_frame && !s->eof) {
+                mixer.underruns++;
+                return;
+            }
+            Uint64 j = i + 1 < s->write_frame ? i + 1 : i;
+            float t = (float)(v->pos & 0xFFFFFFFFu) * (1.0f / 4294967296.0f);
+            const float* a = s->ring + (size_t)(i & mask) * MIXER_CHANNELS;
+            const float* b = s->ring + (size_t)(j & mask) * MIXER_CHANNELS;
+            out[0] += (a[0] + (b[0] - a[0]) * t) * gl;
+            out[1] += (a[1] + (b[1] - a[1]) * t) * gr;
+            out += MIXER_CHANNELS;
+            frames--;
+            v->pos += v->step;
+        }
+        s->read_frame = v->pos >> 32;
+    }
+}
+
+static void mix_chunk(int frames) {
+    memset(mixer.mix, 0, (size_t)frames * MIXER_CHANNELS * sizeof(float));
+    bool refill = false;
+    int playing = 0;
+    for (int i = 0; i < MIXER_MAX_VOICES; i++) {
+        mixer_voice* v = &mixer.voices[i];
+        if (!v->active) {
+            continue;
+        }
+        // Linear pan: the far side fades out, the near side stays at full volume
+        float gl = v->volume * (v->pan > 0.0f ? 1.0f - v->pan : 1.0f);
+        float gr = v->volume * (v->pan < 0.0f ? 1.0f + v->pan : 1.0f);
+        if (v->sound) {
+            mix_sound_voice(v, mixer.mix, frames, gl, gr);
+        } else {
+            lua_SDL_SoundStream* s = v->stream;
+            mix_stream_voice(v, mixer.mix, frames, gl, gr);
+            refill |= !s->eof && s->write_frame - s->read_frame < s->capacity / 2;
+        }
+        playing += v->active;
+    }
+    mix_finish(mixer.mix, frames * MIXER_CHANNELS, mixer.master);
+    mixer.playing = playing;
+    if (refill) {
+        SDL_SignalCondition(mixer.cond);
+    }
+}
+
+// SDL audio thread: produce `additional_amount` bytes, timing each chunk.
+static void mixer_callback(void* userdata, SDL_AudioStream* stream, int additional_amount, int total_amount) {
+    int frames = additional_amount / (int)(MIXER_CHANNELS * sizeof(float));
+    while (frames > 0) {
+        int n = SDL_min(frames, MIXER_CHUNK_FRAMES);
+        Uint64 start = SDL_GetPerformanceCounter();
+        mix_chunk(n);
+        Uint64 ticks = SDL_GetPerformanceCounter() - start;
+        mixer.buffers++;
+        mixer.frames += (Uint64)n;
+        mixer.mix_ticks += ticks;
+        mixer.max_ticks = SDL_max(mixer.max_ticks, ticks);
+        SDL_PutAudioStreamData(stream, mixer.mix, n * MIXER_CHANNELS * (int)sizeof(float));
+        frames -= n;
+    }
+}
+
+// Decode the next block of a stream into its ring. Called with mixer.mutex
+// held; returns true if it did any work. `raw` holds STREAM_READ_FRAMES frames.
+static bool stream_refill(lua_SDL_SoundStream* s, Uint8* raw) {
+    SDL_LockAudioStream(mixer.stream);
+    Uint64 free_frames = s->capacity - (s->write_frame - s->read_frame);
+    bool eof = s->eof;
+    SDL_UnlockAudioStream(mixer.stream);
+    if (eof || free_frames < STREAM_READ_FRAMES) {
+        return false;
+    }
+
+    Sint64 left = s->data_size - s->data_read;
+    size_t want = (size_t)SDL_min((Sint64)STREAM_READ_FRAMES * s->frame_bytes, left);
+    size_t got = want > 0 ? SDL_ReadIO(s->io, raw, want) : 0;
+    got -= got % (size_t)s->frame_bytes;
+    if (got == 0) {
+        if (s->loop && s->data_read > 0 && SDL_SeekIO(s->io, s->data_start, SDL_IO_SEEK_SET) >= 0) {
+            s->data_read = 0;
+        } else {
+            SDL_LockAudioStream(mixer.stream);
+            s->eof = true;
+            SDL_UnlockAudioStream(mixer.stream);
+        }
+        return true;
+    }
+    s->data_read += (Sint64)got;
+
+    SDL_AudioSpec dst = { SDL_AUDIO_F32, MIXER_CHANNELS, s->spec.freq };
+    Uint8* converted = NULL;
+    int converted_len = 0;
+    if (!SDL_ConvertAudioSamples(&s->spec, raw, (int)got, &dst, &converted, &converted_len)) {
+        SDL_LockAudioStream(mixer.stream);
+        s->eof = true; // undecodable data: end the stream instead of spinning
+        SDL_UnlockAudioStream(mixer.stream);
+        return true;
+    }
+
+    const float* src = (const float*)converted;
+    Uint32 frames = (Uint32)(converted_len / (int)(MIXER_CHANNELS * sizeof(float)));
+    SDL_LockAudioStream(mixer.stream);
+    Uint32 mask = s->capacity - 1;
+    while (frames > 0) {
+        Uint32 w = (Uint32)(s->write_frame & mask);
+        Uint32 span = SDL_min(frames, s->capacity - w);
+        memcpy(s->ring + (size_t)w * MIXER_CHANNELS, src, (size_t)span * MIXER_CHANNELS * sizeof(float));
+        src += (size_t)span * MIXER_CHANNELS;
+        s->write_frame += span;
+        frames -= span;
+    }
+    SDL_UnlockAudioStream(mixer.stream);
+    SDL_free(converted);
+    return true;
+}
+
+// Loader thread: keep every listed stream's ring at least half full.
+static int stream_loader(void* data) {
+    Uint8* raw = (Uint8*)malloc((size_t)STREAM_READ_FRAMES * STREAM_MAX_FRAME_BYTES);
+    if (!raw) {
+        return 1;
+    }
+    SDL_LockMutex(mixer.mutex);
+    while (!mixer.quit) {
+        bool busy = false;
+        for (int i = 0; i < mixer.stream_count; i++) {
+            busy |= stream_refill(mixer.streams[i], raw);
+        }
+        if (!busy) {
+            SDL_WaitConditionTimeout(mixer.cond, mixer.mutex, 10);
+        }
+    }
+    SDL_UnlockMutex(mixer.mutex);
+    free(raw);
+    return 0;
+}
+
+static void check_audio_open(lua_State* L) {
+    if (!mixer.stream) {
+        luaL_error(L, "Audio is not open (call sdl.open_audio first)");
+    }
+}
+
+// Close the device and stop the loader; sounds and streams stay valid.
+// The loader locks mixer.stream while refilling, so it is joined before the
+// stream goes away; the callback signals mixer.cond, so that outlives the stream.
+void sdl_audio_close(void) {
+    if (!mixer.stream) {
+        return;
+    }
+    SDL_LockMutex(mixer.mutex);
+    mixer.quit = true;
+    SDL_SignalCondition(mixer.cond);
+    SDL_UnlockMutex(mixer.mutex);
+    SDL_WaitThread(mixer.thread, NULL);
+
+    SDL_DestroyAudioStream(mixer.stream); // no callback runs after this returns
+    mixer.stream = NULL;
+    SDL_DestroyCondition(mixer.cond);
+    SDL_DestroyMutex(mixer.mutex);
+
+    for (int i = 0; i < MIXER_MAX_VOICES; i++) {
+        voice_stop(&mixer.voices[i]);
+    }
+    for (int i = 0; i < mixer.stream_count; i++) {
+        mixer.streams[i]->listed = false;
+    }
+    free(mixer.streams);
+    mixer.streams = NULL;
+    mixer.stream_count = mixer.stream_capacity = 0;
+    mixer.thread = NULL;
+    mixer.mutex = NULL;
+    mixer.cond = NULL;
+    SDL_QuitSubSystem(SDL_INIT_AUDIO);
+}
+
+// Open the default playback device: sdl.open_audio([freq]) -> driver name
+// Initializes the audio subsystem if needed. Under SDL_AUDIO_DRIVER=dummy (or
+// the host's --headless) the mixer runs without sound hardware.
+static int l_sdl_open_audio(lua_State* L) {
+    int freq = (int)luaL_optinteger(L, 1, 48000);
+    if (freq < 8000 || freq > 192000) {
+        luaL_error(L, "Unsupported mixing rate %d", freq);
+    }
+    if (mixer.stream) {
+        luaL_error(L, "Audio is already open");
+    }
+    if (!SDL_InitSubSystem(SDL_INIT_AUDIO)) {
+        luaL_error(L, "Failed to init audio: %s", SDL_GetError());
+    }
+
+    memset(mixer.voices, 0, sizeof(mixer.voices));
+    mixer.freq = freq;
+    mixer.master = 1.0f;
+    mixer.quit = false;
+    mixer.buffers = mixer.frames = mixer.mix_ticks = mixer.max_ticks = 0;
+    mixer.underruns = 0;
+    mixer.playing = 0;
+    mixer.mutex = SDL_CreateMutex();
+    mixer.cond = SDL_CreateCondition();
+    if (!mixer.mutex || !mixer.cond) {
+        SDL_DestroyMutex(mixer.mutex);
+        SDL_DestroyCondition(mixer.cond);
+        mixer.mutex = NULL;
+        mixer.cond = NULL;
+        SDL_QuitSubSystem(SDL_INIT_AUDIO);
+        luaL_error(L, "Failed to create audio mixer lock: %s", SDL_GetError());
+    }
+
+    SDL_AudioSpec spec = { SDL_AUDIO_F32, MIXER_CHANNELS, freq };
+    SDL_AudioStream* stream = SDL_OpenAudioDeviceStream(SDL_AUDIO_DEVICE_DEFAULT_PLAYBACK, &spec, mixer_callback, NULL);
+    if (!stream) {
+        SDL_DestroyMutex(mixer.mutex);
+        SDL_DestroyCondition(mixer.cond);
+        mixer.mutex = NULL;
+        mixer.cond = NULL;
+        SDL_QuitSubSystem(SDL_INIT_AUDIO);
+        luaL_error(L, "Failed to open audio device: %s", SDL_GetError());
+    }
+    mixer.stream = stream;
+    mixer.thread = SDL_CreateThread(stream_loader, "sdl_audio_loader", NULL);
+    if (!mixer.thread) {
+        const char* err = SDL_GetError();
+        lua_pushfstring(L, "Failed to start audio loader thread: %s", err);
+        sdl_audio_close();
+        lua_error(L);
+    }
+    SDL_ResumeAudioStreamDevice(stream); // device streams start paused
+
+    const char* driver = SDL_GetCurrentAudioDriver();
+    lua_pushstring(L, driver ? driver : "unknown");
+    return 1;
+}
+
+// Close the audio device: sdl.close_audio()
+static int l_sdl_close_audio(lua_State* L) {
+    sdl_audio_close();
+    return 0;
+}
+
+static lua_SDL_Sound* check_sound(lua_State* L, int idx) {
+    lua_SDL_Sound* sound = (lua_SDL_Sound*)luaL_checkudata(L, idx, SOUND_MT);
+    if (!sound->data) {
+        luaL_error(L, "Invalid sound (already destroyed)");
+    }
+    return sound;
+}
+
+static int sound_gc(lua_State* L) {
+    lua_SDL_Sound* sound = (lua_SDL_Sound*)luaL_checkudata(L, 1, SOUND_MT);
+    if (mixer.stream) {
+        SDL_LockAudioStream(mixer.stream);
+        for (int i = 0; i < MIXER_MAX_VOICES; i++) {
+            if (mixer.voices[i].sound == sound) {
+                voice_stop(&mixer.voices[i]);
+            }
+        }
+        SDL_UnlockAudioStream(mixer.stream);
+    }
+    SDL_free(sound->data);
+    sound->data = NULL;
+    return 0;
+}
+
+// Decode a whole WAV from io (closed) into a new sound userdata on the stack.
+static int push_sound(lua_State* L, SDL_IOStream* io, const char* name) {
+    SDL_AudioSpec spec;
+    Uint8* buffer = NULL;
+    Uint32 length = 0;
+    if (!io || !SDL_LoadWAV_IO(io, true, &spec, &buffer, &length)) {
+        luaL_error(L, "Failed to load sound '%s': %s", name, SDL_GetError());
+    }
+
+    SDL_AudioSpec dst = { SDL_AUDIO_F32, MIXER_CHANNELS, spec.freq };
+    Uint8* data = NULL;
+    int data_len = 0;
+    bool ok = SDL_ConvertAudioSamples(&spec, buffer, (int)length, &dst, &data, &data_len);
+    SDL_free(buffer);
+    if (!ok) {
+        luaL_error(L, "Failed to convert sound '%s': %s", name, SDL_GetError());
+    }
+
+    lua_SDL_Sound* sound = (lua_SDL_Sound*)lua_newuserdata(L, sizeof(lua_SDL_Sound));
+    sound->data = (float*)data;
+    sound->frames = (Uint32)(data_len / (int)(MIXER_CHANNELS * sizeof(float)));
+    sound->freq = spec.freq;
+    luaL_setmetatable(L, SOUND_MT);
+    return 1;
+}
+
+// Load a WAV file fully into memory: sdl.load_sound(path) -> sound
+static int l_sdl_load_sound(lua_State* L) {
+    const char* path = luaL_checkstring(L, 1);
+    return push_sound(L, SDL_IOFromFile(path, "rb"), path);
+}
+
+// Load a sound from WAV bytes (e.g. read from an asset pack): sdl.load_sound_data(bytes) -> sound
+static int l_sdl_load_sound_data(lua_State* L) {
+    size_t len;
+    const char* bytes = luaL_checklstring(L, 1, &len);
+    return push_sound(L, SDL_IOFromConstMem(bytes, len), "<data>");
+}
+
+// Length of a sound: sdl.sound_length(sound) -> seconds, frames, freq
+static int l_sdl_sound_length(lua_State* L) {
+    lua_SDL_Sound* sound = check_sound(L, 1);
+    lua_pushnumber(L, (double)sound->frames / sound->freq);
+    lua_pushinteger(L, sound->frames);
+    lua_pushinteger(L, sound->freq);
+    return 3;
+}
+
+static lua_SDL_SoundStream* check_sound_stream(lua_State* L, int idx) {
+    lua_SDL_SoundStream* s = (lua_SDL_SoundStream*)luaL_checkudata(L, idx, SOUND_STREAM_MT);
+    if (!s->io) {
+        luaL_error(L, "Invalid sound stream (already destroyed)");
+    }
+    return s;
+}
+
+static int sound_stream_gc(lua_State* L) {
+    lua_SDL_SoundStream* s = (lua_SDL_SoundStream*)luaL_checkudata(L, 1, SOUND_STREAM_MT);
+    if (s->listed) {
+        SDL_LockMutex(mixer.mutex);
+        SDL_LockAudioStream(mixer.stream);
+        if (s->voice >= 0) {
+            voice_stop(&mixer.voices[s->voice]);
+        }
+        for (int i = 0; i < mixer.stream_count; i++) {
+            if (mixer.streams[i] == s) {
+                mixer.streams[i] = mixer.streams[--mixer.stream_count];
+                break;
+            }
+        }
+        SDL_UnlockAudioStream(mixer.stream);
+        SDL_UnlockMutex(mixer.mutex);
+        s->listed = false;
+    }
+    if (s->io) {
+        SDL_CloseIO(s->io);
+        s->io = NULL;
+    }
+    free(s->ring);
+    s->ring = NULL;
+    return 0;
+}
+
+// Read the RIFF header up to the start of the PCM data.
+static bool read_wav_header(lua_SDL_SoundStream* s) {
+    Uint32 riff, size, wave;
+    if (!SDL_ReadU32LE(s->io, &riff) || !SDL_ReadU32LE(s->io, &size) || !SDL_ReadU32LE(s->io, &wave) ||
+        riff != 0x46464952u || wave != 0x45564157u) { // "RIFF", "WAVE"
+        return SDL_SetError("Not a WAV file");
+    }
+    bool have_format = false;
+    for (;;) {
+        Uint32 id, chunk;
+        if (!SDL_ReadU32LE(s->io, &id) || !SDL_ReadU32LE(s->io, &chunk)) {
+            return SDL_SetError("WAV file has no data chunk");
+        }
+        Sint64 next = SDL_TellIO(s->io) + chunk + (chunk & 1);
+        if (id == 0x20746D66u) { // "fmt "
+            Uint16 tag, channels, block, bits;
+            Uint32 rate, byte_rate;
+            if (chunk < 16 || !SDL_ReadU16LE(s->io, &tag) || !SDL_ReadU16LE(s->io, &channels) ||
+                !SDL_ReadU32LE(s->io, &rate) || !SDL_ReadU32LE(s->io, &byte_rate) ||
+                !SDL_ReadU16LE(s->io, &block) || !SDL_ReadU16LE(s->io, &bits)) {
+                return SDL_SetError("Truncated WAV format chunk");
+            }
+            if (tag == 0xFFFE && chunk >= 40) { // WAVE_FORMAT_EXTENSIBLE: tag is the first GUID field
+                Uint16 ext_size, valid_bits;
+                Uint32 channel_mask;
+                if (!SDL_ReadU16LE(s->io, &ext_size) || !SDL_ReadU16LE(s->io, &valid_bits) ||
+                    !SDL_ReadU32LE(s->io, &channel_mask) || !SDL_ReadU16LE(s->io, &tag)) {
+                    return SDL_SetError("Truncated WAV format chunk");
+                }
+            }
+            if (tag == 1 && bits == 8) {
+                s->spec.format = SDL_AUDIO_U8;
+            } else if (tag == 1 && bits == 16) {
+                s->spec.format = SDL_AUDIO_S16LE;
+            } else if (tag == 1 && bits == 32) {
+                s->spec.format = SDL_AUDIO_S32LE;
+            } else if (tag == 3 && bits == 32) {
+                s->spec.format = SDL_AUDIO_F32LE;
+            } else {
+                return SDL_SetError("Unsupported WAV encoding (tag %d, %d bits)", tag, bits);
+            }
+            if (channels == 0 || channels > 8 || block != channels * (bits / 8)) {
+                return SDL_SetError("Invalid WAV format");
+            }
+            if (rate == 0 || rate > WAV_MAX_RATE) {
+                return SDL_SetError("Unsupported WAV sample rate %u", (unsigned)rate);
+            }
+            s->spec.channels = channels;
+            s->spec.freq = (int)rate;
+            s->frame_bytes = block;
+            have_format = true;
+        } else if (id == 0x61746164u) { // "data"
+            if (!have_format) {
+                return SDL_SetError("WAV data before format");
+            }
+            s->data_start = SDL_TellIO(s->io);
+            s->data_size = chunk;
+            return true;
+        }
+        if (SDL_SeekIO(s->io, next, SDL_IO_SEEK_SET) < 0) {
+            return false;
+        }
+    }
+}
+
+// Wrap io (closed on failure) in a new sound stream userdata on the stack.
+static int push_sound_stream(lua_State* L, SDL_IOStream* io, const char* name, lua_Integer buffer_frames) {
+    if (!io) {
+        luaL_error(L, "Failed to open sound stream '%s': %s", name, SDL_GetError());
+    }
+    if (buffer_frames < STREAM_READ_FRAMES * 2 || buffer_frames > (1 << 24)) {
+        SDL_CloseIO(io);
+        luaL_error(L, "Stream buffer must be %d to %d frames", STREAM_READ_FRAMES * 2, 1 << 24);
+    }
+    Uint32 capacity = 1;
+    while (capacity < (Uint32)buffer_frames) {
+        capacity <<= 1;
+    }
+
+    lua_SDL_SoundStream* s = (lua_SDL_SoundStream*)lua_newuserdatauv(L, sizeof(lua_SDL_SoundStream), 1);
+    memset(s, 0, sizeof(lua_SDL_SoundStream));
+    s->io = io;
+    s->voice = -1;
+    luaL_setmetatable(L, SOUND_STREAM_MT); // from here on __gc closes io
+
+    if (!read_wav_header(s)) {
+        luaL_error(L, "Failed to open sound stream '%s': %s", name, SDL_GetError());
+    }
+    s->ring = (float*)malloc((size_t)capacity * MIXER_CHANNELS * sizeof(float));
+    if (!s->ring) {
+        luaL_error(L, "Failed to allocate memory for sound stream");
+    }
+    s->capacity = capacity;
+    return 1;
+}
+
+// Stream a WAV file with bounded buffering: sdl.open_sound_stream(path, [buffer_frames]) -> stream
+static int l_sdl_open_sound_stream(lua_State* L) {
+    const char* path = luaL_checkstring(L, 1);
+    lua_Integer buffer_frames = luaL_optinteger(L, 2, STREAM_DEFAULT_FRAMES);
+    return push_sound_stream(L, SDL_IOFromFile(path, "rb"), path, buffer_frames);
+}
+
+// Stream WAV bytes (e.g. from an asset pack): sdl.open_sound_stream_data(bytes, [buffer_frames]) -> stream
+static int l_sdl_open_sound_stream_data(lua_State* L) {
+    size_t len;
+    const char* bytes = luaL_checklstring(L, 1, &len);
+    lua_Integer buffer_frames = luaL_optinteger(L, 2, STREAM_DEFAULT_FRAMES);
+    push_sound_stream(L, SDL_IOFromConstMem(bytes, len), "<data>", buffer_frames);
+    lua_pushvalue(L, 1);
+    lua_setuservalue(L, -2); // the stream reads the string in place
+    return 1;
+}
+
+// Voice handles carry the slot and its play generation.
+static lua_Integer voice_handle(int index) {
+    return ((lua_Integer)mixer.voices[index].gen << 16) | index;
+}
+
+// Active voice for a handle, or NULL when it finished or was replaced.
+// Called with the audio stream locked.
+static mixer_voice* find_voice(lua_Integer handle) {
+    lua_Integer index = handle & 0xFFFF;
+    if (handle < 0 || index >= MIXER_MAX_VOICES) {
+        return NULL;
+    }
+    mixer_voice* v = &mixer.voices[index];
+    return v->active && (lua_Integer)v->gen == (handle >> 16) ? v : NULL;
+}
+
+static int free_voice(void) {
+    for (int i = 0; i < MIXER_MAX_VOICES; i++) {
+        if (!mixer.voices[i].active) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static Uint64 voice_step(lua_State* L, int freq, float pitch) {
+    if (!(pitch > 0.0f && pitch <= 16.0f)) {
+        luaL_error(L, "Pitch must be in (0, 16]");
+    }
+    return (Uint64)((double)freq * pitch / mixer.freq * 4294967296.0 + 0.5);
+}
+
+static inline bool is_finite(float v) {
+    return !SDL_isinff(v) && !SDL_isnanf(v);
+}
+
+// A gain the mixer can use: one NaN or inf voice would turn the whole output
+// buffer into NaN (and the SIMD clamp into a constant -1).
+static float check_volume(lua_State* L, float volume) {
+    if (!is_finite(volume) || volume < 0.0f) {
+        luaL_error(L, "Volume must be a finite, non-negative number");
+    }
+    return volume;
+}
+
+// Options shared by play_sound/play_stream/set_voice: volume, pan, pitch.
+static void check_voice_params(lua_State* L, int arg, float* volume, float* pan, float* pitch) {
+    *volume = check_volume(L, (float)luaL_optnumber(L, arg, *volume));
+    float p = (float)luaL_optnumber(L, arg + 1, *pan);
+    if (!is_finite(p)) {
+        luaL_error(L, "Pan must be a finite number");
+    }
+    *pan = SDL_clamp(p, -1.0f, 1.0f);
+    *pitch = (float)luaL_optnumber(L, arg + 2, *pitch);
+    if (!is_finite(*pitch)) {
+        luaL_error(L, "Pitch must be a finite number");
+    }
+}
+
+// Play a sound: sdl.play_sound(sound, [volume], [pan], [pitch], [loop]) -> voice | nil when all voices are busy
+static int l_sdl_play_sound(lua_State* L) {
+    lua_SDL_Sound* sound = check_sound(L, 1);
+    float volume = 1.0f, pan = 0.0f, pitch = 1.0f;
+    check_voice_params(L, 2, &volume, &pan, &pitch);
+    bool loop = lua_toboolean(L, 5);
+    check_audio_open(L);
+    Uint64 step = voice_step(L, sound->freq, pitch);
+
+    SDL_LockAudioStream(mixer.stream);
+    int index = free_voice();
+    if (index >= 0) {
+        mixer_voice* v = &mixer.voices[index];
+        v->sound = sound;
+        v->stream = NULL;
+        v->pos = 0;
+        v->step = step;
+        v->volume = volume;
+        v->pan = pan;
+        v->loop = loop;
+        v->gen = (v->gen + 1) & 0x7FFFFFFF;
+        v->active = true;
+    }
+    SDL_UnlockAudioStream(mixer.stream);
+
+    if (index < 0) {
+        lua_pushnil(L);
+    } else {
+        lua_pushinteger(L, voice_handle(index));
+    }
+    return 1;
+}
+
+// Play a sound stream from the start (restarts it if already playing):
+// sdl.play_stream(stream, [volume], [pan], [pitch], [loop]) -> voice | nil when all voices are busy
+static int l_sdl_play_stream(lua_State* L) {
+    lua_SDL_SoundStream* s = check_sound_stream(L, 1);
+    float volume = 1.0f, pan = 0.0f, pitch = 1.0f;
+    check_voice_params(L, 2, &volume, &pan, &pitch);
+    bool loop = lua_toboolean(L, 5);
+    check_audio_open(L);
+    Uint64 step = voice_step(L, s->spec.freq, pitch);
+
+    SDL_LockMutex(mixer.mutex); // keeps the loader off the stream while it rewinds
+    if (!s->listed) {
+        if (mixer.stream_count == mixer.stream_capacity) {
+            int capacity = mixer.stream_capacity > 0 ? mixer.stream_capacity * 2 : 8;
+            lua_SDL_SoundStream** streams = (lua_SDL_SoundStream**)realloc(mixer.streams, capacity * sizeof(lua_SDL_SoundStream*));
+            if (!streams) {
+                SDL_UnlockMutex(mixer.mutex);
+                luaL_error(L, "Failed to allocate memory for sound streams");
+            }
+            mixer.streams = streams;
+            mixer.stream_capacity = capacity;
+        }
+        mixer.streams[mixer.stream_count++] = s;
+        s->listed = true;
+    }
+
+    SDL_LockAudioStream(mixer.stream);
+    int index = s->voice >= 0 ? s->voice : free_voice();
+    if (index >= 0) {
+        mixer_voice* v = &mixer.voices[index];
+        voice_stop(v);
+        SDL_SeekIO(s->io, s->data_start, SDL_IO_SEEK_SET);
+        s->data_read = 0;
+        s->write_frame = s->read_frame = 0;
+        s->eof = false;
+        s->loop = loop;
+        s->voice = index;
+        v->stream = s;
+        v->pos = 0;
+        v->step = step;
+        v->volume = volume;
+        v->pan = pan;
+        v->loop = loop;
+        v->gen = (v->gen + 1) & 0x7FFFFFFF;
+        v->active = true;
+    }
+    SDL_UnlockAudioStream(mixer.stream);
+
+    if (index >= 0) {
+        // Decode the first blocks now so playback does not start with an underrun
+        Uint8* raw = (Uint8*)malloc((size_t)STREAM_READ_FRAMES * STREAM_MAX_FRAME_BYTES);
+        if (raw) {
+            for (int i = 0; i < 2 && stream_refill(s, raw); i++) {
+            }
+            free(raw);
+        }
+        SDL_SignalCondition(mixer.cond);
+    }
+    SDL_UnlockMutex(mixer.mutex);
+
+    if (index < 0) {
+        lua_pushnil(L);
+    } else {
+        lua_pushinteger(L, voice_handle(index));
+    }
+    return 1;
+}
+
+// Change a playing voice: sdl.set_voice(voice, [volume], [pan], [pitch]) -> still playing
+static int l_sdl_set_voice(lua_State* L) {
+    lua_Integer handle = luaL_checkinteger(L, 1);
+    check_audio_open(L);
+
+    SDL_LockAudioStream(mixer.stream);
+    mixer_voice* v = find_voice(handle);
+    float volume = 0.0f, pan = 0.0f, pitch = 1.0f;
+    int freq = 0;
+    if (v) {
+        volume = v->volume;
+        pan = v->pan;
+        freq = v->sound ? v->sound->freq : v->stream->spec.freq;
+        pitch = (float)((double)v->step / 4294967296.0 * mixer.freq / freq);
+    }
+    SDL_UnlockAudioStream(mixer.stream); // argument errors below must not leave the lock held
+    if (!v) {
+        lua_pushboolean(L, false);
+        return 1;
+    }
+
+    check_voice_params(L, 2, &volume, &pan, &pitch);
+    Uint64 step = voice_step(L, freq, pitch);
+    SDL_LockAudioStream(mixer.stream);
+    v = find_voice(handle); // may have finished meanwhile
+    if (v) {
+        v->volume = volume;
+        v->pan = pan;
+        v->step = step;
+    }
+    SDL_UnlockAudioStream(mixer.stream);
+    lua_pushboolean(L, v != NULL);
+    return 1;
+}
+
+// Stop a voice (no effect once it finished): sdl.stop_voice(voice)
+static int l_sdl_stop_voice(lua_State* L) {
+    lua_Integer handle = luaL_checkinteger(L, 1);
+    check_audio_open(L);
+    SDL_LockAudioStream(mixer.stream);
+    mixer_voice* v = find_voice(handle);
+    if (v) {
+        voice_stop(v);
+    }
+    SDL_UnlockAudioStream(mixer.stream);
+    return 0;
+}
+
+// Stop every voice: sdl.stop_all_voices()
+static int l_sdl_stop_all_voices(lua_State* L) {
+    check_audio_open(L);
+    SDL_LockAudioStream(mixer.stream);
+    for (int i = 0; i < MIXER_MAX_VOICES; i++) {
+        voice_stop(&mixer.voices[i]);
+    }
+    SDL_UnlockAudioStream(mixer.stream);
+    return 0;
+}
+
+// sdl.voice_playing(voice) -> boolean
+static int l_sdl_voice_playing(lua_State* L) {
+    lua_Integer handle = luaL_checkinteger(L, 1);
+    bool playing = false;
+    if (mixer.stream) {
+        SDL_LockAudioStream(mixer.stream);
+        playing = find_voice(handle) != NULL;
+        SDL_UnlockAudioStream(mixer.stream);
+    }
+    lua_pushboolean(L, playing);
+    return 1;
+}
+
+// sdl.set_master_volume(volume)
+static int l_sdl_set_master_volume(lua_State* L) {
+    float volume = check_volume(L, (float)luaL_checknumber(L, 1));
+    check_audio_open(L);
+    SDL_LockAudioStream(mixer.stream);
+    mixer.master = volume;
+    SDL_UnlockAudioStream(mixer.stream);
+    return 0;
+}
+
+// Mixer cost per buffer of up to 1024 frames:
+// sdl.audio_stats([reset]) -> buffers, avg_us, max_us, load, voices, underruns
+// load is mixing time divided by the duration of the audio mixed.
+static int l_sdl_audio_stats(lua_State* L) {
+    bool reset = lua_toboolean(L, 1);
+    check_audio_open(L);
+    SDL_LockAudioStream(mixer.stream);
+    Uint64 buffers = mixer.buffers, frames = mixer.frames, ticks = mixer.mix_ticks, max_ticks = mixer.max_ticks;
+    Uint32 underruns = mixer.underruns;
+    int playing = mixer.playing;
+    if (reset) {
+        mixer.buffers = mixer.frames = mixer.mix_ticks = mixer.max_ticks = 0;
+        mixer.underruns = 0;
+    }
+    SDL_UnlockAudioStream(mixer.stream);
+
+    double us_per_tick = 1e6 / (double)SDL_GetPerformanceFrequency();
+    double mixed_us = frames > 0 ? (double)frames * 1e6 / mixer.freq : 0.0;
+    lua_pushinteger(L, (lua_Integer)buffers);
+    lua_pushnumber(L, buffers > 0 ? (double)ticks * us_per_tick / (double)buffers : 0.0);
+    lua_pushnumber(L, (double)max_ticks * us_per_tick);
+    lua_pushnumber(L, mixed_us > 0.0 ? (double)ticks * us_per_tick / mixed_us : 0.0);
+    lua_pushinteger(L, playing);
+    lua_pushinteger(L, underruns);
+    return 6;
+}
+
+static const struct luaL_Reg audio_lib[] = {
+    {"open_audio", l_sdl_open_audio},
+    {"close_audio", l_sdl_close_audio},
+    {"load_sound", l_sdl_load_sound},
+    {"load_sound_data", l_sdl_load_sound_data},
+    {"sound_length", l_sdl_sound_length},
+    {"open_sound_stream", l_sdl_open_sound_stream},
+    {"open_sound_stream_data", l_sdl_open_sound_stream_data},
+    {"play_sound", l_sdl_play_sound},
+    {"play_stream", l_sdl_play_stream},
+    {"set_voice", l_sdl_set_voice},
+    {"stop_voice", l_sdl_stop_voice},
+    {"stop_all_voices", l_sdl_stop_all_voices},
+    {"voice_playing", l_sdl_voice_playing},
+    {"set_master_volume", l_sdl_set_master_volume},
+    {"audio_stats", l_sdl_audio_stats},
+    {NULL, NULL}
+};
+
+// Create the sound metatables and add the audio functions to the sdl module table.
+void sdl_audio_register(lua_State* L) {
+    luaL_newmetatable(L, SOUND_MT);
+    lua_pushcfunction(L, sound_gc);
+    lua_setfield(L, -2, "__gc");
+    lua_pop(L, 1);
+
+    luaL_newmetatable(L, SOUND_STREAM_MT);
+    lua_pushcfunction(L, sound_stream_gc);
+    lua_setfield(L, -2, "__gc");
+    lua_pop(L, 1);
+
+    luaL_setfuncs(L, audio_lib, 0);
+
+    lua_pushinteger(L, SDL_INIT_AUDIO);
+    lua_setfield(L, -2, "INIT_AUDIO");
+}
@@ -0,0 +1,107 @@
+// sdl_batch.c
+// Per-renderer geometry batch: many small draws are appended here and
+// submitted with one SDL_RenderGeometry call. Vertices are written in world
+// space and run through the renderer transform in bulk (sdl_transform.c).
+#include "module_sdl.h"
+#include <stdlib.h>
+
+// Flush early once the batch gets this big so the scratch stays cache sized.
+#define SDL_BATCH_FLUSH_VERTICES 262144
+
+// Grow an array to hold at least `needed` elements (doubling).
+static bool grow_array(void** data, int* capacity, int needed, size_t elem_size) {
+    if (needed <= *capacity) {
+        return true;
+    }
+    int cap = *capacity > 0 ? *capacity : 1024;
+    while (cap < needed) {
+        cap *= 2;
+    }
+    void* p = realloc(*data, (size_t)cap * elem_size);
+    if (!p) {
+        return false;
+    }
+    *data = p;
+    *capacity = cap;
+    return true;
+}
+
+// Submit pending geometry: sdl.render_flush(renderer) and before any immediate draw.
+void sdl_batch_flush(lua_State* L, lua_SDL_Renderer* ud) {
+    sdl_batch* batch = &ud->batch;
+    if (batch->index_count == 0) {
+        batch->vertex_count = 0;
+        batch->transformed = 0;
+        return;
+    }
+    sdl_batch_apply_transform(ud);
+
+    bool ok = SDL_RenderGeometry(ud->renderer, batch->texture, batch->vertices, batch->vertex_count,
+                                 batch->indices, batch->index_count);
+    batch->vertex_count = 0;
+    batch->index_count = 0;
+    batch->transformed = 0;
+    batch->texture = NULL;
+    if (!ok) {
+        luaL_error(L, "Failed to render batched geometry: %s", SDL_GetError());
+    }
+}
+
+// Reserve room for num_vertices/num_indices in the batch. Returns the vertex slots
+// to fill, the index slots in *indices and the index of the first vertex in *base.
+SDL_Vertex* sdl_batch_alloc(lua_State* L, lua_SDL_Renderer* ud, SDL_Texture* texture,
+                            int num_vertices, int num_indices, int** indices, int* base) {
+    sdl_batch* batch = &ud->batch;
+
+    // Geometry for another texture (or a full batch) has to go out first
+    if (batch->index_count > 0 &&
+        (batch->texture != texture || batch->vertex_count + num_vertices > SDL_BATCH_FLUSH_VERTICES)) {
+        sdl_batch_flush(L, ud);
+    }
+    batch->texture = texture;
+
+    if (!grow_array((void**)&batch->vertices, &batch->vertex_capacity,
+                    batch->vertex_count + num_vertices, sizeof(SDL_Vertex)) ||
+        !grow_array((void**)&batch->indices, &batch->index_capacity,
+                    batch->index_count + num_indices, sizeof(int))) {
+        luaL_error(L, "Failed to allocate memory for batched geometry");
+    }
+
+    SDL_Vertex* vertices = batch->vertices + batch->vertex_count;
+    *indices = batch->indices + batch->index_count;
+    *base = batch->vertex_count;
+    batch->vertex_count += num_vertices;
+    batch->index_count += num_indices;
+    return vertices;
+}
+
+// Current draw color as a vertex color.
+SDL_FColor sdl_batch_draw_color(lua_SDL_Renderer* ud) {
+    SDL_FColor color = { 1.0f, 1.0f, 1.0f, 1.0f };
+    SDL_GetRenderDrawColorFloat(ud->renderer, &color.r, &color.g, &color.b, &color.a);
+    return color;
+}
+
+// Position scratch for draws that bypass the batch but still need the
+// transform applied. Owned by the renderer, released with the batch.
+SDL_FPoint* sdl_batch_points(lua_State* L, lua_SDL_Renderer* ud, int count) {
+    sdl_batch* batch = &ud->batch;
+    if (!grow_array((void**)&batch->points, &batch->point_capacity, count, sizeof(SDL_FPoint))) {
+        luaL_error(L, "Failed to allocate memory for vertices");
+    }
+    return batch->points;
+}
+
+void sdl_batch_free(sdl_batch* batch) {
+    free(batch->vertices);
+    free(batch->indices);
+    free(batch->points);
+    batch->vertices = NULL;
+    batch->indices = NULL;
+    batch->points = NULL;
+    batch->point_capacity = 0;
+    batch->vertex_count = batch->vertex_capacity = 0;
+    batch->index_count = batch->index_capacity = 0;
+    batch->transformed = 0;
+    batch->texture = NULL;
+}
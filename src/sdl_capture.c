@@ -0,0 +1,539 @@
+// sdl_capture.c
+// Asynchronous frame capture. render_present reads the finished frame back
+// into a ring of preallocated RGBA surfaces and a writer thread saves them, so
+// the render thread never waits on disk. When every slot is still waiting to
+// be written the frame is dropped and counted instead of blocking.
+//
+// Raw sequence format: per frame u32 width, u32 height, u32 frame number
+// (little endian), then width*height*4 bytes of RGBA32 pixels.
+#include "module_sdl.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define CAPTURE_PATH_MAX 1024
+#define CAPTURE_DEFAULT_SLOTS 8
+
+enum { SLOT_FREE, SLOT_FULL };
+
+typedef struct {
+    SDL_Surface* surface;
+    Uint32 frame;
+    int state;
+} capture_slot;
+
+struct sdl_capture {
+    char path[CAPTURE_PATH_MAX]; // printf pattern taking the frame number, or the raw file
+    bool raw;
+    int every;                   // capture every Nth presented frame, 0 = only on request
+    bool capture_next;           // capture the next frame regardless of `every`
+    Uint32 frame;                // presented frames since start
+
+    capture_slot* slots;
+    int slot_count;
+    int head, tail; // producer / writer positions in the ring
+
+    SDL_IOStream* raw_io;
+    SDL_Thread* thread;
+    SDL_Mutex* mutex;
+    SDL_Condition* cond;
+    bool quit;
+
+    Uint32 captured, written, dropped, failed;
+};
+
+// A BMP path pattern may hold one %d (with optional zero pad/width) and %%.
+static bool valid_pattern(const char* path) {
+    int conversions = 0;
+    for (const char* p = path; *p; p++) {
+        if (*p != '%') {
+            continue;
+        }
+        p++;
+        if (*p == '%') {
+            continue;
+        }
+        while (*p >= '0' && *p <= '9') {
+            p++;
+        }
+        if (*p != 'd') {
+            return false;
+        }
+        conversions++;
+    }
+    return conversions == 1;
+}
+
+static bool write_slot(sdl_capture* cap, capture_slot* slot) {
+    SDL_Surface* s = slot->surface;
+    if (cap->raw) {
+        if (!SDL_WriteU32LE(cap->raw_io, (Uint32)s->w) || !SDL_WriteU32LE(cap->raw_io, (Uint32)s->h) ||
+            !SDL_WriteU32LE(cap->raw_io, slot->frame)) {
+            return false;
+        }
+        size_t row = (size_t)s->w * 4;
+        for (int y = 0; y < s->h; y++) {
+            if (SDL_WriteIO(cap->raw_io, (Uint8*)s->pixels + (size_t)y * s->pitch, row) != row) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    char path[CAPTURE_PATH_MAX + 32];
+    SDL_snprintf(path, sizeof(path), cap->path, (int)slot->frame);
+    return SDL_SaveBMP(s, path);
+}
+
+// Writer thread: save full slots in order until stopped and drained.
+static int capture_writer(void* data) {
+    sdl_capture* cap = (sdl_capture*)data;
+    SDL_LockMutex(cap->mutex);
+    for (;;) {
+        capture_slot* slot = &cap->slots[cap->tail];
+        if (slot->state != SLOT_FULL) {
+            if (cap->quit) {
+                break;
+            }
+            SDL_WaitCondition(cap->cond, cap->mutex);
+            continue;
+        }
+        SDL_UnlockMutex(cap->mutex);
+
+        bool ok = write_slot(cap, slot);
+
+        SDL_LockMutex(cap->mutex);
+        if (ok) {
+            cap->written++;
+        } else {
+            cap->failed++;
+        }
+        slot->state = SLOT_FREE;
+        cap->tail = (cap->tail + 1) % cap->slot_count;
+    }
+    SDL_UnlockMutex(cap->mutex);
+    return 0;
+}
+
+void sdl_capture_stop(lua_SDL_Renderer* ud) {
+    sdl_capture* cap = ud->capture;
+    if (!cap) {
+        return;
+    }
+    ud->capture = NULL;
+
+    if (cap->thread) {
+        SDL_LockMutex(cap->mutex);
+        cap->quit = true;
+        SDL_SignalCondition(cap->cond);
+        SDL_UnlockMutex(cap->mutex);
+        SDL_WaitThread(cap->thread, NULL);
+    }
+    if (cap->dropped > 0 || cap->failed > 0) {
+        SDL_Log("Frame capture: %u written, %u dropped (writer behind), %u failed",
+                cap->written, cap->dropped, cap->failed);
+    }
+
+    for (int i = 0; i < cap->slot_count; i++) {
+        SDL_DestroySurface(cap->slots[i].surface);
+    }
+    free(cap->slots);
+    if (cap->raw_io) {
+        SDL_CloseIO(cap->raw_io);
+    }
+    if (cap->cond) {
+        SDL_DestroyCondition(cap->cond);
+    }
+    if (cap->mutex) {
+        SDL_DestroyMutex(cap->mutex);
+    }
+    free(cap);
+}
+
+// Read the frame about to be presented into the next free slot. Called from
+// render_present after the batch is flushed and before SDL_RenderPresent.
+void sdl_capture_frame(lua_SDL_Renderer* ud) {
+    sdl_capture* cap = ud->capture;
+    if (!cap) {
+        return;
+    }
+    Uint32 frame = cap->frame++;
+    bool selected = cap->capture_next || (cap->every > 0 && frame % (Uint32)cap->every == 0);
+    if (!selected) {
+        return;
+    }
+    cap->capture_next = false;
+
+    SDL_LockMutex(cap->mutex);
+    capture_slot* slot = &cap->slots[cap->head];
+    bool free_slot = slot->state == SLOT_FREE;
+    if (!free_slot) {
+        cap->dropped++;
+    }
+    SDL_UnlockMutex(cap->mutex);
+    if (!free_slot) {
+        return;
+    }
+
+    // The slot is ours until it is marked full
+    SDL_Surface* frame_pixels = SDL_RenderReadPixels(ud->renderer, NULL);
+    if (!frame_pixels) {
+        SDL_LockMutex(cap->mutex);
+        cap->failed++;
+        SDL_UnlockMutex(cap->mutex);
+        return;
+    }
+    if (!slot->surface || slot->surface->w != frame_pixels->w || slot->surface->h != frame_pixels->h) {
+        SDL_DestroySurface(slot->surface);
+        slot->surface = SDL_CreateSurface(frame_pixels->w, frame_pixels->h, SDL_PIXELFORMAT_RGBA32);
+    }
+    bool ok = slot->surface &&
+              SDL_ConvertPixels(frame_pixels->w, frame_pixels->h, frame_pixels->format, frame_pixels->pixels,
+                                frame_pixels->pitch, SDL_PIXELFORMAT_RGBA32, slot->surface->pixels,
+                                slot->surface->pitch);
+    SDL_DestroySurface(frame_pixels);
+
+    SDL_LockMutex(cap->mutex);
+    if (ok) {
+        slot->frame = frame;
+        slot->state = SLOT_FULL;
+        cap->head = (cap->head + 1) % cap->slot_count;
+        cap->captured++;
+        SDL_SignalCondition(cap->cond);
+    } else {
+        cap->failed++;
+    }
+    SDL_UnlockMutex(cap->mutex);
+}
+
+// Start capturing presented frames: sdl.start_capture(renderer, path, [options])
+// path is a printf pattern for BMP files ("shots/frame_%05d.bmp") or, with
+// options.format = "raw", one file receiving the whole sequence.
+// options: every (capture every Nth frame, 0 = only after capture_next), slots (ring size)
+static int l_sdl_start_capture(lua_State* L) {
+    lua_SDL_Renderer* ud = lua_check_SDL_Renderer(L, 1);
+    const char* path = luaL_checkstring(L, 2);
+    int every = 1;
+    int slots = CAPTURE_DEFAULT_SLOTS;
+    bool raw = false;
+
+    if (!ud->renderer) {
+        luaL_error(L, "No renderer available");
+    }
+    if (!lua_isnoneornil(L, 3)) {
+        luaL_checktype(L, 3, LUA_TTABLE);
+        lua_getfield(L, 3, "every");
+        every = (int)luaL_optinteger(L, -1, every);
+        lua_getfield(L, 3, "slots");
+        slots = (int)luaL_optinteger(L, -1, slots);
+        lua_getfield(L, 3, "format");
+        const char* format = luaL_optstring(L, -1, "bmp");
+        if (strcmp(format, "raw") == 0) {
+            raw = true;
+        } else if (strcmp(format, "bmp") != 0) {
+            luaL_error(L, "Unknown capture format '%s' (expected 'bmp' or 'raw')", format);
+        }
+        lua_pop(L, 3);
+    }
+    if (every < 0 || slots < 1) {
+        luaL_error(L, "Invalid capture options (every >= 0, slots >= 1)");
+    }
+    if (strlen(path) >= CAPTURE_PATH_MAX) {
+        luaL_error(L, "Capture path too long");
+    }
+    if (!raw && !valid_pattern(path)) {
+        luaL_error(L, "Capture path '%s' needs exactly one %%d for the frame number", path);
+    }
+
+    sdl_capture_stop(ud);
+
+    sdl_capture* cap = (sdl_capture*)calloc(1, sizeof(sdl_capture));
+    if (!cap) {
+        luaL_error(L, "Failed to allocate frame capture");
+    }
+    strcpy(cap->path, path);
+    cap->raw = raw;
+    cap->every = every;
+    cap->slot_count = slots;
+    cap->slots = (capture_slot*)calloc(slots, sizeof(capture_slot));
+    ud->capture = cap; // from here on sdl_capture_stop cleans up
+
+    if (!cap->slots) {
+        sdl_capture_stop(ud);
+        luaL_error(L, "Failed to allocate capture ring");
+    }
+
+    // Preallocate the ring at the current output size
+    int w = 0, h = 0;
+    SDL_GetCurrentRenderOutputSize(ud->renderer, &w, &h);
+    for (int i = 0; i < slots && w > 0 && h > 0; i++) {
+        cap->slots[i].surface = SDL_CreateSurface(w, h, SDL_PIXELFORMAT_RGBA32);
+        if (!cap->slots[i].surface) {
+            sdl_capture_stop(ud);
+            luaL_error(L, "Failed to allocate capture surface: %s", SDL_GetError());
+        }
+    }
+
+    if (raw) {
+        cap->raw_io = SDL_IOFromFile(path, "wb");
+        if (!cap->raw_io) {
+            sdl_capture_stop(ud);
+            luaL_error(L, "Failed to open '%s': %s", path, SDL_GetError());
+        }
+    }
+
+    cap->mutex = SDL_CreateMutex();
+    cap->cond = SDL_CreateCondition();
+    if (cap->mutex && cap->cond) {
+        cap->thread = SDL_CreateThread(capture_writer, "sdl_capture", cap);
+    }
+    if (!cap->thread) {
+        sdl_capture_stop(ud);
+        luaL_error(L, "Failed to start capture writer: %s", SDL_GetError());
+    }
+    return 0;
+}
+
+// Capture the next presented frame even if `every` would skip it: sdl.capture_next(renderer)
+static int l_sdl_capture_next(lua_State* L) {
+    lua_SDL_Renderer* ud = lua_check_SDL_Renderer(L, 1);
+    if (!ud->capture) {
+        luaL_error(L, "Frame capture is not running");
+    }
+    ud->capture->capture_next = true;
+    return 0;
+}
+
+static int push_capture_stats(lua_State* L, sdl_capture* cap) {
+    SDL_LockMutex(cap->mutex);
+    lua_pushinteger(L, cap->captured);
+    lua_pushinteger(L, cap->written);
+    lua_pushinteger(L, cap->dropped);
+    SDL_UnlockMutex(cap->mutex);
+    return 3;
+}
+
+// Capture counters: sdl.capture_stats(renderer) -> captured, written, dropped
+static int l_sdl_capture_stats(lua_State* L) {
+    lua_SDL_Renderer* ud = lua_check_SDL_Renderer(L, 1);
+    if (!ud->capture) {
+        lua_pushinteger(L, 0);
+        lua_pushinteger(L, 0);
+        lua_pushinteger(L, 0);
+        return 3;
+    }
+    return push_capture_stats(L, ud->capture);
+}
+
+// Stop capturing, waiting for queued frames to be written:
+// sdl.stop_capture(renderer) -> captured, written, dropped
+static int l_sdl_stop_capture(lua_State* L) {
+    lua_SDL_Renderer* ud = lua_check_SDL_Renderer(L, 1);
+    sdl_capture* cap = ud->capture;
+    if (!cap) {
+        return 0;
+    }
+    // Let the writer drain first so the counts are final
+    SDL_LockMutex(cap->mutex);
+    cap->quit = true;
+    SDL_SignalCondition(cap->cond);
+    SDL_UnlockMutex(cap->mutex);
+    SDL_WaitThread(cap->thread, NULL);
+    cap->thread = NULL;
+
+    int n = push_capture_stats(L, cap);
+    sdl_capture_stop(ud);
+    return n;
+}
+
+// Read the current frame as an RGBA32 surface (caller destroys it).
+static SDL_Surface* read_frame(lua_SDL_Renderer* ud) {
+    SDL_Surface* pixels = SDL_RenderReadPixels(ud->renderer, NULL);
+    if (!pixels || pixels->format == SDL_PIXELFORMAT_RGBA32) {
+        return pixels;
+    }
+    SDL_Surface* rgba = SDL_ConvertSurface(pixels, SDL_PIXELFORMAT_RGBA32);
+    SDL_DestroySurface(pixels);
+    return rgba;
+}
+
+// Compare a frame with a golden BMP. Returns false if the golden image cannot
+// be loaded; otherwise fills the number of pixels with a channel differing by
+// more than tolerance and the largest channel difference (-1 on size mismatch).
+static bool compare_frame(SDL_Surface* frame, const char* golden_path, int tolerance,
+                          int* differing, int* max_diff) {
+    SDL_Surface* loaded = SDL_LoadBMP(golden_path);
+    if (!loaded) {
+        return false;
+    }
+    SDL_Surface* golden = SDL_ConvertSurface(loaded, SDL_PIXELFORMAT_RGBA32);
+    SDL_DestroySurface(loaded);
+    if (!golden) {
+        return false;
+    }
+
+    *differing = 0;
+    *max_diff = 0;
+    if (golden->w != frame->w || golden->h != frame->h) {
+        *differing = frame->w * frame->h;
+        *max_diff = -1;
+        SDL_DestroySurface(golden);
+        return true;
+    }
+
+    int row = frame->w * 4;
+    for (int y = 0; y < frame->h; y++) {
+        const Uint8* a = (const Uint8*)frame->pixels + (size_t)y * frame->pitch;
+        const Uint8* b = (const Uint8*)golden->pixels + (size_t)y * golden->pitch;
+        for (int x = 0; x < row; x += 4) {
+            int worst = 0;
+            for (int c = 0; c < 4; c++) {
+                int d = a[x + c] > b[x + c] ? a[x + c] - b[x + c] : b[x + c] - a[x + c];
+                if (d > worst) worst = d;
+            }
+            if (worst > tolerance) (*differing)++;
+            if (worst > *max_diff) *max_diff = worst;
+        }
+    }
+    SDL_DestroySurface(golden);
+    return true;
+}
+
+// Golden check run by the host on the last frame of a --frames run
+enum { GOLDEN_NOT_RUN, GOLDEN_PASSED, GOLDEN_WRITTEN, GOLDEN_MISSING, GOLDEN_FAILED };
+
+static const char* golden_path = NULL;
+static int golden_tolerance = 0;
+static bool golden_update = false;
+static int golden_result = GOLDEN_NOT_RUN;
+
+// update = true writes the frame as the new reference instead of comparing.
+void sdl_capture_set_golden(const char* path, int tolerance, bool update) {
+    golden_path = path;
+    golden_tolerance = tolerance;
+    golden_update = update;
+    golden_result = GOLDEN_NOT_RUN;
+}
+
+bool sdl_capture_golden_failed(void) {
+    return golden_result == GOLDEN_FAILED || (golden_path && golden_result == GOLDEN_NOT_RUN);
+}
+
+// The reference does not exist yet: the host reports the check as skipped.
+bool sdl_capture_golden_missing(void) {
+    return golden_result == GOLDEN_MISSING;
+}
+
+// Compare the frame about to be presented with the golden image, or write it
+// in update mode. A mismatch fails and a missing reference is reported as
+// missing; either way the frame is saved next to it as <golden>.actual.bmp.
+void sdl_capture_golden(lua_SDL_Renderer* ud) {
+    if (!golden_path) {
+        return;
+    }
+    SDL_Surface* frame = read_frame(ud);
+    if (!frame) {
+        SDL_Log("Golden: failed to read pixels: %s", SDL_GetError());
+        golden_result = GOLDEN_FAILED;
+        return;
+    }
+
+    int differing, max_diff;
+    char actual[CAPTURE_PATH_MAX + 16];
+    SDL_snprintf(actual, sizeof(actual), "%s.actual.bmp", golden_path);
+    if (golden_update) {
+        if (SDL_SaveBMP(frame, golden_path)) {
+            SDL_Log("Golden: wrote reference %s", golden_path);
+            golden_result = GOLDEN_WRITTEN;
+        } else {
+            SDL_Log("Golden: cannot write %s: %s", golden_path, SDL_GetError());
+            golden_result = GOLDEN_FAILED;
+        }
+    } else if (!SDL_GetPathInfo(golden_path, NULL)) {
+        SDL_SaveBMP(frame, actual);
+        SDL_Log("Golden: no reference %s yet, frame saved to %s; use --update-golden to create it",
+                golden_path, actual);
+        golden_result = GOLDEN_MISSING;
+    } else if (!compare_frame(frame, golden_path, golden_tolerance, &differing, &max_diff)) {
+        SDL_SaveBMP(frame, actual);
+        SDL_Log("Golden: cannot load reference %s (%s), frame saved to %s; use --update-golden to accept it",
+                golden_path, SDL_GetError(), actual);
+        golden_result = GOLDEN_FAILED;
+    } else if (differing > 0) {
+        SDL_SaveBMP(frame, actual);
+        if (max_diff < 0) {
+            SDL_Log("Golden: %s size differs, frame saved to %s", golden_path, actual);
+        } else {
+            SDL_Log("Golden: %s differs in %d pixels (max channel diff %d, tolerance %d), frame saved to %s",
+                    golden_path, differing, max_diff, golden_tolerance, actual);
+        }
+        golden_result = GOLDEN_FAILED;
+    } else {
+        golden_result = GOLDEN_PASSED;
+    }
+    SDL_DestroySurface(frame);
+}
+
+// Save the current frame as BMP (call before render_present): sdl.save_screenshot(renderer, path)
+static int l_sdl_save_screenshot(lua_State* L) {
+    lua_SDL_Renderer* ud = lua_check_SDL_Renderer(L, 1);
+    const char* path = luaL_checkstring(L, 2);
+
+    if (!ud->renderer) {
+        luaL_error(L, "No renderer available");
+    }
+    sdl_batch_flush(L, ud);
+
+    SDL_Surface* frame = read_frame(ud);
+    if (!frame) {
+        luaL_error(L, "Failed to read pixels: %s", SDL_GetError());
+    }
+    bool ok = SDL_SaveBMP(frame, path);
+    SDL_DestroySurface(frame);
+    if (!ok) {
+        luaL_error(L, "Failed to save screenshot '%s': %s", path, SDL_GetError());
+    }
+    return 0;
+}
+
+// Compare the current frame with a BMP:
+// sdl.compare_screenshot(renderer, path, [tolerance]) -> match, differing_pixels, max_channel_diff
+static int l_sdl_compare_screenshot(lua_State* L) {
+    lua_SDL_Renderer* ud = lua_check_SDL_Renderer(L, 1);
+    const char* path = luaL_checkstring(L, 2);
+    int tolerance = (int)luaL_optinteger(L, 3, 0);
+
+    if (!ud->renderer) {
+        luaL_error(L, "No renderer available");
+    }
+    sdl_batch_flush(L, ud);
+
+    SDL_Surface* frame = read_frame(ud);
+    if (!frame) {
+        luaL_error(L, "Failed to read pixels: %s", SDL_GetError());
+    }
+    int differing, max_diff;
+    bool loaded = compare_frame(frame, path, tolerance, &differing, &max_diff);
+    SDL_DestroySurface(frame);
+    if (!loaded) {
+        luaL_error(L, "Failed to load '%s': %s", path, SDL_GetError());
+    }
+    lua_pushboolean(L, differing == 0);
+    lua_pushinteger(L, differing);
+    lua_pushinteger(L, max_diff);
+    return 3;
+}
+
+static const struct luaL_Reg capture_lib[] = {
+    {"start_capture", l_sdl_start_capture},
+    {"capture_next", l_sdl_capture_next},
+    {"capture_stats", l_sdl_capture_stats},
+    {"stop_capture", l_sdl_stop_capture},
+    {"save_screenshot", l_sdl_save_screenshot},
+    {"compare_screenshot", l_sdl_compare_screenshot},
+    {NULL, NULL}
+};
+
+// Add the frame capture functions to the sdl module table on top of the stack.
+void sdl_capture_register(lua_State* L) {
+    luaL_setfuncs(L, capture_lib, 0);
+}
@@ -0,0 +1,474 @@
+// sdl_collision.c
+// Collision world of axis aligned boxes and circles indexed by the spatial
+// hash grid. Bodies are updated incrementally (only cells a body enters or
+// leaves are touched), overlapping pairs are found per grid cell and returned
+// as one flat table, and point/rect/circle queries replace O(n^2) loops in Lua.
+#include "module_sdl.h"
+#include <stdlib.h>
+#include <string.h>
+
+static const char* WORLD_MT = "sdl.world";
+
+enum {
+    BODY_RECT = 1,
+    BODY_CIRCLE = 2 // circle inscribed in the body box
+};
+
+typedef struct {
+    SDL_FRect box;
+    Uint8 shape; // 0 = free slot
+} world_body;
+
+typedef struct {
+    sdl_grid grid;
+    world_body* bodies;
+    Uint32* stamps; // last query that visited each body, for dedupe
+    int count, capacity;
+    int* free_ids;
+    int free_count, free_capacity;
+    int live;
+    Uint32 stamp;
+    int* found; // scratch for query results and pairs
+    int found_count, found_capacity;
+} lua_SDL_World;
+
+static lua_SDL_World* check_world(lua_State* L, int idx) {
+    lua_SDL_World* world = (lua_SDL_World*)luaL_checkudata(L, idx, WORLD_MT);
+    if (!world->grid.cell_size) {
+        luaL_error(L, "Invalid world (already destroyed)");
+    }
+    return world;
+}
+
+static int world_gc(lua_State* L) {
+    lua_SDL_World* world = (lua_SDL_World*)luaL_checkudata(L, 1, WORLD_MT);
+    sdl_grid_free(&world->grid);
+    free(world->bodies);
+    free(world->stamps);
+    free(world->free_ids);
+    free(world->found);
+    memset(world, 0, sizeof(lua_SDL_World));
+    return 0;
+}
+
+// Lua ids are 1-based body slots.
+static int check_body(lua_State* L, lua_SDL_World* world, int arg) {
+    lua_Integer id = luaL_checkinteger(L, arg);
+    if (id < 1 || id > world->count || world->bodies[id - 1].shape == 0) {
+        luaL_error(L, "Invalid body id %d", (int)id);
+    }
+    return (int)id - 1;
+}
+
+static void found_reserve(lua_State* L, lua_SDL_World* world, int extra) {
+    if (world->found_count + extra <= world->found_capacity) {
+        return;
+    }
+    int capacity = world->found_capacity > 0 ? world->found_capacity : 256;
+    while (capacity < world->found_count + extra) {
+        capacity *= 2;
+    }
+    int* found = (int*)realloc(world->found, capacity * sizeof(int));
+    if (!found) {
+        luaL_error(L, "Failed to allocate memory for collision results");
+    }
+    world->found = found;
+    world->found_capacity = capacity;
+}
+
+static inline bool boxes_overlap(const SDL_FRect* a, const SDL_FRect* b) {
+    return a->x <= b->x + b->w && a->x + a->w >= b->x && a->y <= b->y + b->h && a->y + a->h >= b->y;
+}
+
+static inline bool circle_rect_overlap(const SDL_FRect* circle, const SDL_FRect* rect) {
+    float r = circle->w * 0.5f;
+    float cx = circle->x + r, cy = circle->y + r;
+    float px = SDL_clamp(cx, rect->x, rect->x + rect->w);
+    float py = SDL_clamp(cy, rect->y, rect->y + rect->h);
+    float dx = cx - px, dy = cy - py;
+    return dx * dx + dy * dy <= r * r;
+}
+
+// Exact shape test; callers have already checked the boxes overlap.
+static bool shapes_overlap(const world_body* a, const world_body* b) {
+    if (a->shape == BODY_RECT && b->shape == BODY_RECT) {
+        return true;
+    }
+    if (a->shape == BODY_CIRCLE && b->shape == BODY_CIRCLE) {
+        float ra = a->box.w * 0.5f, rb = b->box.w * 0.5f;
+        float dx = (a->box.x + ra) - (b->box.x + rb);
+        float dy = (a->box.y + ra) - (b->box.y + rb);
+        return dx * dx + dy * dy <= (ra + rb) * (ra + rb);
+    }
+    return a->shape == BODY_CIRCLE ? circle_rect_overlap(&a->box, &b->box) : circle_rect_overlap(&b->box, &a->box);
+}
+
+typedef struct {
+    lua_State* L;
+    lua_SDL_World* world;
+    world_body shape; // query shape
+    int skip; // body id excluded from results, or -1
+} world_query_ctx;
+
+static void visit_query(int id, void* ctx) {
+    world_query_ctx* q = (world_query_ctx*)ctx;
+    lua_SDL_World* world = q->world;
+    if (world->stamps[id] == world->stamp || id == q->skip) {
+        return;
+    }
+    world->stamps[id] = world->stamp;
+    const world_body* b = &world->bodies[id];
+    if (!boxes_overlap(&b->box, &q->shape.box) || !shapes_overlap(b, &q->shape)) {
+        return;
+    }
+    found_reserve(q->L, world, 1);
+    world->found[world->found_count++] = id;
+}
+
+static int compare_ids(const void* a, const void* b) {
+    int x = *(const int*)a, y = *(const int*)b;
+    return (x > y) - (x < y);
+}
+
+// Collect ids of bodies overlapping `shape`, sorted by id.
+static void world_query(lua_State* L, lua_SDL_World* world, const world_body* shape, int skip) {
+    if (++world->stamp == 0) {
+        // Stamp wrapped: clear so old marks cannot match
+        memset(world->stamps, 0, world->count * sizeof(Uint32));
+        world->stamp = 1;
+    }
+    world->found_count = 0;
+    world_query_ctx q = { L, world, *shape, skip };
+    sdl_grid_query(&world->grid, &shape->box, visit_query, &q);
+    qsort(world->found, world->found_count, sizeof(int), compare_ids);
+}
+
+// Push world->found as 1-based ids into arg `out` (reused when a table) or a new table.
+static void push_found(lua_State* L, lua_SDL_World* world, int out) {
+    int n = world->found_count;
+    if (lua_istable(L, out)) {
+        lua_pushvalue(L, out); // reuse the caller's table, clearing the old tail
+        int old = (int)lua_rawlen(L, -1);
+        for (int i = old; i > n; i--) {
+            lua_pushnil(L);
+            lua_rawseti(L, -2, i);
+        }
+    } else {
+        lua_createtable(L, n, 0);
+    }
+    for (int i = 0; i < n; i++) {
+        lua_pushinteger(L, world->found[i] + 1);
+        lua_rawseti(L, -2, i + 1);
+    }
+}
+
+// Create a collision world: sdl.create_world([cell_size])
+static int l_sdl_create_world(lua_State* L) {
+    float cell_size = (float)luaL_optnumber(L, 1, 64.0);
+    if (cell_size <= 0.0f) {
+        luaL_error(L, "Cell size must be positive");
+    }
+
+    lua_SDL_World* world = (lua_SDL_World*)lua_newuserdata(L, sizeof(lua_SDL_World));
+    memset(world, 0, sizeof(lua_SDL_World));
+    sdl_grid_init(&world->grid, cell_size);
+    luaL_setmetatable(L, WORLD_MT);
+    return 1;
+}
+
+static inline bool is_finite(float v) {
+    return !SDL_isinff(v) && !SDL_isnanf(v);
+}
+
+// Finite arguments can still give a box the grid refuses (too many cells, or
+// an overflow to inf once the radius is applied).
+static void check_grid_box(lua_State* L, const lua_SDL_World* world, const SDL_FRect* box) {
+    if (!sdl_grid_box_valid(&world->grid, box)) {
+        luaL_error(L, "Body must be finite and cover at most 65536 grid cells");
+    }
+}
+
+// The slot is only taken once the grid insert succeeded, so a failed add
+// leaves no body behind.
+static int world_add(lua_State* L, lua_SDL_World* world, const world_body* body) {
+    check_grid_box(L, world, &body->box);
+    int id;
+    if (world->free_count > 0) {
+        id = world->free_ids[world->free_count - 1];
+    } else {
+        if (world->count == world->capacity) {
+            int capacity = world->capacity > 0 ? world->capacity * 2 : 1024;
+            world_body* bodies = (world_body*)realloc(world->bodies, capacity * sizeof(world_body));
+            if (!bodies) {
+                luaL_error(L, "Failed to allocate memory for bodies");
+            }
+            world->bodies = bodies;
+            Uint32* stamps = (Uint32*)realloc(world->stamps, capacity * sizeof(Uint32));
+            if (!stamps) {
+                luaL_error(L, "Failed to allocate memory for bodies");
+            }
+            world->stamps = stamps;
+            world->capacity = capacity;
+        }
+        id = world->count;
+    }
+    if (!sdl_grid_insert(&world->grid, id, &body->box)) {
+        luaL_error(L, "Failed to allocate memory for collision grid");
+    }
+    if (world->free_count > 0) {
+        world->free_count--;
+    } else {
+        world->count++;
+    }
+
+    world->bodies[id] = *body;
+    world->stamps[id] = 0;
+    world->live++;
+    return id;
+}
+
+static void check_circle(lua_State* L, int arg, world_body* body) {
+    float cx = (float)luaL_checknumber(L, arg);
+    float cy = (float)luaL_checknumber(L, arg + 1);
+    float r = (float)luaL_checknumber(L, arg + 2);
+    if (!is_finite(cx) || !is_finite(cy) || !is_finite(r)) {
+        luaL_error(L, "Circle center and radius must be finite");
+    }
+    if (r < 0.0f) {
+        luaL_error(L, "Radius must not be negative");
+    }
+    body->box.x = cx - r;
+    body->box.y = cy - r;
+    body->box.w = body->box.h = r * 2.0f;
+    body->shape = BODY_CIRCLE;
+}
+
+static void check_rect(lua_State* L, int arg, world_body* body) {
+    body->box.x = (float)luaL_checknumber(L, arg);
+    body->box.y = (float)luaL_checknumber(L, arg + 1);
+    body->box.w = (float)luaL_checknumber(L, arg + 2);
+    body->box.h = (float)luaL_checknumber(L, arg + 3);
+    if (!is_finite(body->box.x) || !is_finite(body->box.y) || !is_finite(body->box.w) || !is_finite(body->box.h)) {
+        luaL_error(L, "Rect position and size must be finite");
+    }
+    if (body->box.w < 0.0f || body->box.h < 0.0f) {
+        luaL_error(L, "Rect size must not be negative");
+    }
+    body->shape = BODY_RECT;
+}
+
+// Add a box body: sdl.world_add_rect(world, x, y, w, h) -> id
+static int l_sdl_world_add_rect(lua_State* L) {
+    lua_SDL_World* world = check_world(L, 1);
+    world_body body;
+    check_rect(L, 2, &body);
+    lua_pushinteger(L, world_add(L, world, &body) + 1);
+    return 1;
+}
+
+// Add a circle body: sdl.world_add_circle(world, cx, cy, radius) -> id
+static int l_sdl_world_add_circle(lua_State* L) {
+    lua_SDL_World* world = check_world(L, 1);
+    world_body body;
+    check_circle(L, 2, &body);
+    lua_pushinteger(L, world_add(L, world, &body) + 1);
+    return 1;
+}
+
+// Move or resize a body: sdl.world_move(world, id, x, y, [w], [h]) for rects,
+// sdl.world_move(world, id, cx, cy, [radius]) for circles
+static int l_sdl_world_move(lua_State* L) {
+    lua_SDL_World* world = check_world(L, 1);
+    int id = check_body(L, world, 2);
+    world_body* body = &world->bodies[id];
+    float x = (float)luaL_checknumber(L, 3);
+    float y = (float)luaL_checknumber(L, 4);
+
+    SDL_FRect box = body->box;
+    if (body->shape == BODY_CIRCLE) {
+        float r = (float)luaL_optnumber(L, 5, box.w * 0.5f);
+        if (!is_finite(x) || !is_finite(y) || !is_finite(r)) {
+            luaL_error(L, "Circle center and radius must be finite");
+        }
+        if (r < 0.0f) {
+            luaL_error(L, "Radius must not be negative");
+        }
+        box.x = x - r;
+        box.y = y - r;
+        box.w = box.h = r * 2.0f;
+    } else {
+        box.x = x;
+        box.y = y;
+        box.w = (float)luaL_optnumber(L, 5, box.w);
+        box.h = (float)luaL_optnumber(L, 6, box.h);
+        if (!is_finite(x) || !is_finite(y) || !is_finite(box.w) || !is_finite(box.h)) {
+            luaL_error(L, "Rect position and size must be finite");
+        }
+        if (box.w < 0.0f || box.h < 0.0f) {
+            luaL_error(L, "Rect size must not be negative");
+        }
+    }
+    check_grid_box(L, world, &box);
+
+    if (!sdl_grid_move(&world->grid, id, &body->box, &box)) {
+        luaL_error(L, "Failed to allocate memory for collision grid");
+    }
+    body->box = box;
+    return 0;
+}
+
+// Shape and bounding box of a body: sdl.world_get(world, id) -> shape, x, y, w, h
+static int l_sdl_world_get(lua_State* L) {
+    lua_SDL_World* world = check_world(L, 1);
+    int id = check_body(L, world, 2);
+    const world_body* body = &world->bodies[id];
+    lua_pushinteger(L, body->shape);
+    lua_pushnumber(L, body->box.x);
+    lua_pushnumber(L, body->box.y);
+    lua_pushnumber(L, body->box.w);
+    lua_pushnumber(L, body->box.h);
+    return 5;
+}
+
+// Remove a body (its id may be reused): sdl.world_remove(world, id)
+static int l_sdl_world_remove(lua_State* L) {
+    lua_SDL_World* world = check_world(L, 1);
+    int id = check_body(L, world, 2);
+
+    if (world->free_count == world->free_capacity) {
+        int capacity = world->free_capacity > 0 ? world->free_capacity * 2 : 256;
+        int* free_ids = (int*)realloc(world->free_ids, capacity * sizeof(int));
+        if (!free_ids) {
+            luaL_error(L, "Failed to allocate memory for world free list");
+        }
+        world->free_ids = free_ids;
+        world->free_capacity = capacity;
+    }
+
+    sdl_grid_remove(&world->grid, id, &world->bodies[id].box);
+    world->bodies[id].shape = 0;
+    world->free_ids[world->free_count++] = id;
+    world->live--;
+    return 0;
+}
+
+// Number of live bodies: sdl.world_count(world)
+static int l_sdl_world_count(lua_State* L) {
+    lua_SDL_World* world = check_world(L, 1);
+    lua_pushinteger(L, world->live);
+    return 1;
+}
+
+// All overlapping pairs as a flat list {a1, b1, a2, b2, ...} with a < b:
+// sdl.world_pairs(world, [out_table]) -> table, pair count
+static int l_sdl_world_pairs(lua_State* L) {
+    lua_SDL_World* world = check_world(L, 1);
+    const sdl_grid* grid = &world->grid;
+    world->found_count = 0;
+
+    for (int i = 0; i < grid->capacity; i++) {
+        const sdl_grid_cell* c = &grid->cells[i];
+        if (!c->occupied || c->count < 2) {
+            continue;
+        }
+        for (int j = 0; j < c->count; j++) {
+            const world_body* a = &world->bodies[c->items[j]];
+            for (int k = j + 1; k < c->count; k++) {
+                const world_body* b = &world->bodies[c->items[k]];
+                if (!boxes_overlap(&a->box, &b->box)) {
+                    continue;
+                }
+                // Bodies sharing several cells: report only from the cell holding
+                // the top-left corner of the box intersection
+                SDL_FRect corner = { SDL_max(a->box.x, b->box.x), SDL_max(a->box.y, b->box.y), 0.0f, 0.0f };
+                int r[4];
+                sdl_grid_cell_range(grid, &corner, r);
+                if (r[0] != c->cx || r[1] != c->cy || !shapes_overlap(a, b)) {
+                    continue;
+                }
+                int ia = c->items[j], ib = c->items[k];
+                found_reserve(L, world, 2);
+                world->found[world->found_count++] = SDL_min(ia, ib);
+                world->found[world->found_count++] = SDL_max(ia, ib);
+            }
+        }
+    }
+
+    push_found(L, world, 2);
+    lua_pushinteger(L, world->found_count / 2);
+    return 2;
+}
+
+// Bodies containing a point: sdl.world_query_point(world, x, y, [out_table]) -> table
+static int l_sdl_world_query_point(lua_State* L) {
+    lua_SDL_World* world = check_world(L, 1);
+    world_body shape;
+    shape.box.x = (float)luaL_checknumber(L, 2);
+    shape.box.y = (float)luaL_checknumber(L, 3);
+    shape.box.w = shape.box.h = 0.0f;
+    shape.shape = BODY_RECT;
+    world_query(L, world, &shape, -1);
+    push_found(L, world, 4);
+    return 1;
+}
+
+// Bodies overlapping a rect: sdl.world_query_rect(world, x, y, w, h, [out_table]) -> table
+static int l_sdl_world_query_rect(lua_State* L) {
+    lua_SDL_World* world = check_world(L, 1);
+    world_body shape;
+    check_rect(L, 2, &shape);
+    world_query(L, world, &shape, -1);
+    push_found(L, world, 6);
+    return 1;
+}
+
+// Bodies overlapping a circle: sdl.world_query_circle(world, cx, cy, radius, [out_table]) -> table
+static int l_sdl_world_query_circle(lua_State* L) {
+    lua_SDL_World* world = check_world(L, 1);
+    world_body shape;
+    check_circle(L, 2, &shape);
+    world_query(L, world, &shape, -1);
+    push_found(L, world, 5);
+    return 1;
+}
+
+// Bodies overlapping another body: sdl.world_query_body(world, id, [out_table]) -> table
+static int l_sdl_world_query_body(lua_State* L) {
+    lua_SDL_World* world = check_world(L, 1);
+    int id = check_body(L, world, 2);
+    world_body shape = world->bodies[id];
+    world_query(L, world, &shape, id);
+    push_found(L, world, 3);
+    return 1;
+}
+
+static const struct luaL_Reg collision_lib[] = {
+    {"create_world", l_sdl_create_world},
+    {"world_add_rect", l_sdl_world_add_rect},
+    {"world_add_circle", l_sdl_world_add_circle},
+    {"world_move", l_sdl_world_move},
+    {"world_get", l_sdl_world_get},
+    {"world_remove", l_sdl_world_remove},
+    {"world_count", l_sdl_world_count},
+    {"world_pairs", l_sdl_world_pairs},
+    {"world_query_point", l_sdl_world_query_point},
+    {"world_query_rect", l_sdl_world_query_rect},
+    {"world_query_circle", l_sdl_world_query_circle},
+    {"world_query_body", l_sdl_world_query_body},
+    {NULL, NULL}
+};
+
+// Create the world metatable and add the collision functions to the sdl module table.
+void sdl_collision_register(lua_State* L) {
+    luaL_newmetatable(L, WORLD_MT);
+    lua_pushcfunction(L, world_gc);
+    lua_setfield(L, -2, "__gc");
+    lua_pop(L, 1);
+
+    luaL_setfuncs(L, collision_lib, 0);
+
+    lua_pushinteger(L, BODY_RECT);
+    lua_setfield(L, -2, "BODY_RECT");
+    lua_pushinteger(L, BODY_CIRCLE);
+    lua_setfield(L, -2, "BODY_CIRCLE");
+}
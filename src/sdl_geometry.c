@@ -0,0 +1,360 @@
+// sdl_geometry.c
+// Reusable geometry buffers. Index buffers hold 0-based 16 or 32-bit indices
+// converted once at creation, float buffers hold plain vertex data (positions,
+// colors, uvs) that render_geometry_raw submits through SDL_RenderGeometryRaw
+// with per-attribute offsets and strides, so SoA or interleaved data is drawn
+// without building SDL_Vertex arrays.
+#include "module_sdl.h"
+#include <stdlib.h>
+#include <string.h>
+
+static const char* INDEX_BUFFER_MT = "sdl.index_buffer";
+static const char* FLOAT_BUFFER_MT = "sdl.float_buffer";
+
+typedef struct {
+    void* data;
+    int count;
+    int size;      // bytes per index: 2 or 4
+    int max_index; // largest index, checked against the vertex count
+} lua_SDL_IndexBuffer;
+
+typedef struct {
+    float* data;
+    int count;
+} lua_SDL_FloatBuffer;
+
+static lua_SDL_IndexBuffer* check_index_buffer(lua_State* L, int idx) {
+    return (lua_SDL_IndexBuffer*)luaL_checkudata(L, idx, INDEX_BUFFER_MT);
+}
+
+static lua_SDL_FloatBuffer* check_float_buffer(lua_State* L, int idx) {
+    return (lua_SDL_FloatBuffer*)luaL_checkudata(L, idx, FLOAT_BUFFER_MT);
+}
+
+static lua_SDL_IndexBuffer* test_index_buffer(lua_State* L, int idx) {
+    return (lua_SDL_IndexBuffer*)luaL_testudata(L, idx, INDEX_BUFFER_MT);
+}
+
+static int index_buffer_gc(lua_State* L) {
+    lua_SDL_IndexBuffer* ib = check_index_buffer(L, 1);
+    free(ib->data);
+    ib->data = NULL;
+    return 0;
+}
+
+static int index_buffer_len(lua_State* L) {
+    lua_pushinteger(L, check_index_buffer(L, 1)->count);
+    return 1;
+}
+
+// Create an index buffer from 1-based Lua indices: sdl.create_index_buffer(indices, [bits])
+// bits is 16 or 32; by default 16 is used when every index fits.
+static int l_sdl_create_index_buffer(lua_State* L) {
+    luaL_checktype(L, 1, LUA_TTABLE);
+    int bits = (int)luaL_optinteger(L, 2, 0);
+    int count = (int)lua_rawlen(L, 1);
+
+    if (bits != 0 && bits != 16 && bits != 32) {
+        luaL_error(L, "Index buffer bits must be 16 or 32, got %d", bits);
+    }
+
+    lua_SDL_IndexBuffer* ib = (lua_SDL_IndexBuffer*)lua_newuserdata(L, sizeof(lua_SDL_IndexBuffer));
+    memset(ib, 0, sizeof(lua_SDL_IndexBuffer));
+    luaL_setmetatable(L, INDEX_BUFFER_MT);
+
+    // Read into 32-bit first, then narrow if possible
+    int* indices = (int*)malloc((count > 0 ? count : 1) * sizeof(int));
+    if (!indices) {
+        luaL_error(L, "Failed to allocate memory for indices");
+    }
+    ib->data = indices; // owned by the userdata from here on
+    ib->count = count;
+    ib->size = 4;
+    for (int i = 1; i <= count; i++) {
+        lua_rawgeti(L, 1, i);
+        lua_Integer index = luaL_checkinteger(L, -1) - 1; // Lua indices are 1-based
+        lua_pop(L, 1);
+        if (index < 0 || index > 0x7fffffff) {
+            luaL_error(L, "Index %d out of range", i);
+        }
+        indices[i - 1] = (int)index;
+        if (index > ib->max_index) {
+            ib->max_index = (int)index;
+        }
+    }
+
+    if (bits == 16 && ib->max_index > 0xffff) {
+        luaL_error(L, "Index %d does not fit 16 bits", ib->max_index + 1);
+    }
+    if (bits == 16 || (bits == 0 && ib->max_index <= 0xffff)) {
+        Uint16* narrow = (Uint16*)malloc((count > 0 ? count : 1) * sizeof(Uint16));
+        if (!narrow) {
+            luaL_error(L, "Failed to allocate memory for indices");
+        }
+        for (int i = 0; i < count; i++) {
+            narrow[i] = (Uint16)indices[i];
+        }
+        free(indices);
+        ib->data = narrow;
+        ib->size = 2;
+    }
+    return 1;
+}
+
+// Bits per index of a buffer: sdl.index_buffer_bits(buffer) -> 16 | 32
+static int l_sdl_index_buffer_bits(lua_State* L) {
+    lua_pushinteger(L, check_index_buffer(L, 1)->size * 8);
+    return 1;
+}
+
+static int float_buffer_gc(lua_State* L) {
+    lua_SDL_FloatBuffer* fb = check_float_buffer(L, 1);
+    free(fb->data);
+    fb->data = NULL;
+    return 0;
+}
+
+static int float_buffer_len(lua_State* L) {
+    lua_pushinteger(L, check_float_buffer(L, 1)->count);
+    return 1;
+}
+
+// buffer[i] (1-based)
+static int float_buffer_index(lua_State* L) {
+    lua_SDL_FloatBuffer* fb = check_float_buffer(L, 1);
+    lua_Integer i = luaL_checkinteger(L, 2);
+    if (i < 1 || i > fb->count) {
+        lua_pushnil(L);
+    } else {
+        lua_pushnumber(L, fb->data[i - 1]);
+    }
+    return 1;
+}
+
+// buffer[i] = value (1-based)
+static int float_buffer_newindex(lua_State* L) {
+    lua_SDL_FloatBuffer* fb = check_float_buffer(L, 1);
+    lua_Integer i = luaL_checkinteger(L, 2);
+    if (i < 1 || i > fb->count) {
+        luaL_error(L, "Float buffer index %d out of range (1..%d)", (int)i, fb->count);
+    }
+    fb->data[i - 1] = (float)luaL_checknumber(L, 3);
+    return 0;
+}
+
+// Copy a Lua array into the buffer starting at 1-based position `first`.
+static void float_buffer_fill(lua_State* L, lua_SDL_FloatBuffer* fb, int first, int table) {
+    int n = (int)lua_rawlen(L, table);
+    if (first < 1 || first - 1 + n > fb->count) {
+        luaL_error(L, "Float buffer write of %d values at %d exceeds size %d", n, first, fb->count);
+    }
+    float* dst = fb->data + (first - 1);
+    for (int i = 1; i <= n; i++) {
+        lua_rawgeti(L, table, i);
+        dst[i - 1] = (float)luaL_checknumber(L, -1);
+        lua_pop(L, 1);
+    }
+}
+
+// Create a float buffer from a size (zeroed) or an array: sdl.create_float_buffer(size | values)
+static int l_sdl_create_float_buffer(lua_State* L) {
+    int count;
+    bool from_table = lua_istable(L, 1);
+    if (from_table) {
+        count = (int)lua_rawlen(L, 1);
+    } else {
+        lua_Integer n = luaL_checkinteger(L, 1);
+        if (n < 0 || n > 0x7fffffff / (lua_Integer)sizeof(float)) {
+            luaL_error(L, "Invalid float buffer size %d", (int)n);
+        }
+        count = (int)n;
+    }
+
+    lua_SDL_FloatBuffer* fb = (lua_SDL_FloatBuffer*)lua_newuserdata(L, sizeof(lua_SDL_FloatBuffer));
+    fb->data = NULL;
+    fb->count = 0;
+    luaL_setmetatable(L, FLOAT_BUFFER_MT);
+
+    fb->data = (float*)calloc(count > 0 ? count : 1, sizeof(float));
+    if (!fb->data) {
+        luaL_error(L, "Failed to allocate float buffer of %d values", count);
+    }
+    fb->count = count;
+    if (from_table) {
+        float_buffer_fill(L, fb, 1, 1);
+    }
+    return 1;
+}
+
+// Overwrite part of a buffer: sdl.float_buffer_set(buffer, first, values)
+static int l_sdl_float_buffer_set(lua_State* L) {
+    lua_SDL_FloatBuffer* fb = check_float_buffer(L, 1);
+    int first = (int)luaL_checkinteger(L, 2);
+    luaL_checktype(L, 3, LUA_TTABLE);
+    float_buffer_fill(L, fb, first, 3);
+    return 0;
+}
+
+// One attribute stream of render_geometry_raw: buffer plus offset/stride in floats.
+typedef struct {
+    const float* data;
+    int stride; // floats
+} raw_stream;
+
+// Read {name} / {name}_offset / {name}_stride from the options table and
+// check that `count` elements of `width` floats fit in the buffer.
+static bool read_stream(lua_State* L, int opts, const char* name, int width, int count, raw_stream* out) {
+    char field[32];
+    lua_getfield(L, opts, name);
+    if (lua_isnil(L, -1)) {
+        lua_pop(L, 1);
+        return false;
+    }
+    lua_SDL_FloatBuffer* fb = (lua_SDL_FloatBuffer*)luaL_testudata(L, -1, FLOAT_BUFFER_MT);
+    if (!fb) {
+        luaL_error(L, "Geometry field '%s' must be a float buffer", name);
+    }
+    lua_pop(L, 1); // still referenced by the options table
+
+    SDL_snprintf(field, sizeof(field), "%s_offset", name);
+    lua_getfield(L, opts, field);
+    lua_Integer offset = luaL_optinteger(L, -1, 0);
+    SDL_snprintf(field, sizeof(field), "%s_stride", name);
+    lua_getfield(L, opts, field);
+    lua_Integer stride = luaL_optinteger(L, -1, width);
+    lua_pop(L, 2);
+
+    if (offset < 0 || stride < 0 || (stride > 0 && stride < width) ||
+        offset + (lua_Integer)(count - 1) * stride + width > fb->count) {
+        luaL_error(L, "Geometry field '%s' (offset %d, stride %d) does not hold %d vertices",
+                   name, (int)offset, (int)stride, count);
+    }
+    out->data = fb->data + offset;
+    out->stride = (int)stride;
+    return true;
+}
+
+// Draw geometry from float buffers with SDL_RenderGeometryRaw:
+// sdl.render_geometry_raw(renderer, texture, {
+//     count = n, xy = buf, [xy_offset = 0], [xy_stride = 2],
+//     [color = buf, color_offset, color_stride = 4],  -- RGBA floats, default: draw color
+//     [uv = buf, uv_offset, uv_stride = 2],           -- required with a texture
+//     [indices = index_buffer] })
+// Offsets and strides count floats; a stride of 0 repeats one value for all vertices.
+static int l_sdl_render_geometry_raw(lua_State* L) {
+    lua_SDL_Renderer* ud = lua_check_SDL_Renderer(L, 1);
+    SDL_Texture* texture = NULL;
+    if (!lua_isnil(L, 2)) {
+        texture = lua_check_SDL_Texture(L, 2)->texture;
+    }
+    luaL_checktype(L, 3, LUA_TTABLE);
+
+    if (!ud->renderer) {
+        luaL_error(L, "No renderer available");
+    }
+
+    lua_getfield(L, 3, "count");
+    int count = (int)luaL_checkinteger(L, -1);
+    lua_pop(L, 1);
+    if (count <= 0) {
+        return 0;
+    }
+
+    raw_stream xy, color, uv;
+    if (!read_stream(L, 3, "xy", 2, count, &xy)) {
+        luaL_error(L, "Geometry needs an 'xy' float buffer");
+    }
+    SDL_FColor draw_color = sdl_batch_draw_color(ud);
+    if (!read_stream(L, 3, "color", 4, count, &color)) {
+        color.data = &draw_color.r;
+        color.stride = 0;
+    }
+    bool has_uv = read_stream(L, 3, "uv", 2, count, &uv);
+    if (texture && !has_uv) {
+        luaL_error(L, "Textured geometry needs a 'uv' float buffer");
+    }
+
+    lua_getfield(L, 3, "indices");
+    lua_SDL_IndexBuffer* ib = NULL;
+    if (!lua_isnil(L, -1)) {
+        ib = test_index_buffer(L, -1);
+        if (!ib) {
+            luaL_error(L, "Geometry field 'indices' must be an index buffer");
+        }
+        if (ib->count > 0 && ib->max_index >= count) {
+            luaL_error(L, "Index %d exceeds vertex count %d", ib->max_index + 1, count);
+        }
+    }
+    lua_pop(L, 1);
+
+    sdl_batch_flush(L, ud);
+
+    const float* positions = xy.data;
+    int position_stride = xy.stride * (int)sizeof(float);
+    if (!sdl_transform_is_identity(&ud->transform)) {
+        SDL_FPoint* points = sdl_batch_points(L, ud, count);
+        for (int i = 0; i < count; i++) {
+            points[i].x = xy.data[(size_t)i * xy.stride];
+            points[i].y = xy.data[(size_t)i * xy.stride + 1];
+        }
+        sdl_transform_points(&ud->transform, points, count);
+        positions = &points[0].x;
+        position_stride = sizeof(SDL_FPoint);
+    }
+
+    if (!SDL_RenderGeometryRaw(ud->renderer, texture,
+                               positions, position_stride,
+                               (const SDL_FColor*)color.data, color.stride * (int)sizeof(float),
+                               has_uv ? uv.data : NULL, has_uv ? uv.stride * (int)sizeof(float) : 0,
+                               count,
+                               ib ? ib->data : NULL, ib ? ib->count : 0, ib ? ib->size : 0)) {
+        luaL_error(L, "Failed to render geometry: %s", SDL_GetError());
+    }
+    return 0;
+}
+
+// Submit SDL_Vertex data with an index buffer (used by render_geometry).
+bool sdl_render_indexed(lua_State* L, int idx, SDL_Renderer* renderer, SDL_Texture* texture,
+                        const SDL_Vertex* vertices, int num_vertices) {
+    lua_SDL_IndexBuffer* ib = check_index_buffer(L, idx);
+    if (ib->count > 0 && ib->max_index >= num_vertices) {
+        luaL_error(L, "Index %d exceeds vertex count %d", ib->max_index + 1, num_vertices);
+    }
+    return SDL_RenderGeometryRaw(renderer, texture,
+                                 &vertices[0].position.x, sizeof(SDL_Vertex),
+                                 &vertices[0].color, sizeof(SDL_Vertex),
+                                 &vertices[0].tex_coord.x, sizeof(SDL_Vertex),
+                                 num_vertices, ib->data, ib->count, ib->size);
+}
+
+static const struct luaL_Reg geometry_lib[] = {
+    {"create_index_buffer", l_sdl_create_index_buffer},
+    {"index_buffer_bits", l_sdl_index_buffer_bits},
+    {"create_float_buffer", l_sdl_create_float_buffer},
+    {"float_buffer_set", l_sdl_float_buffer_set},
+    {"render_geometry_raw", l_sdl_render_geometry_raw},
+    {NULL, NULL}
+};
+
+// Create the buffer metatables and add the geometry functions.
+void sdl_geometry_register(lua_State* L) {
+    luaL_newmetatable(L, INDEX_BUFFER_MT);
+    lua_pushcfunction(L, index_buffer_gc);
+    lua_setfield(L, -2, "__gc");
+    lua_pushcfunction(L, index_buffer_len);
+    lua_setfield(L, -2, "__len");
+    lua_pop(L, 1);
+
+    luaL_newmetatable(L, FLOAT_BUFFER_MT);
+    lua_pushcfunction(L, float_buffer_gc);
+    lua_setfield(L, -2, "__gc");
+    lua_pushcfunction(L, float_buffer_len);
+    lua_setfield(L, -2, "__len");
+    lua_pushcfunction(L, float_buffer_index);
+    lua_setfield(L, -2, "__index");
+    lua_pushcfunction(L, float_buffer_newindex);
+    lua_setfield(L, -2, "__newindex");
+    lua_pop(L, 1);
+
+    luaL_setfuncs(L, geometry_lib, 0);
+}
@@ -0,0 +1,304 @@
+// sdl_grid.c
+// Uniform spatial hash grid over integer item ids. Cells live in an open
+// addressing table keyed by cell coordinates, so only occupied cells cost
+// memory and the world has no fixed bounds. An item is stored in every cell
+// its box touches; queries may report an id more than once and callers dedupe.
+// A cell whose last item leaves stays in the table as a tombstone, so probe
+// chains stay intact; new cells reuse tombstones and rehashing drops them.
+#include "module_sdl.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define GRID_MIN_CAPACITY 256
+#define GRID_COORD_LIMIT (1 << 30) // cell coordinates are clamped to +-this
+#define GRID_MAX_ITEM_CELLS 65536  // cells a single inserted box may cover
+
+static inline Uint32 cell_hash(int cx, int cy) {
+    return ((Uint32)cx * 73856093u) ^ ((Uint32)cy * 19349663u);
+}
+
+// Clamped so huge or non-finite coordinates never overflow the int cast.
+static inline int cell_coord(float v, float inv_cell) {
+    double c = SDL_floor((double)v * inv_cell);
+    if (!(c > -GRID_COORD_LIMIT)) {
+        return -GRID_COORD_LIMIT; // also NaN
+    }
+    return c < GRID_COORD_LIMIT ? (int)c : GRID_COORD_LIMIT;
+}
+
+void sdl_grid_init(sdl_grid* grid, float cell_size) {
+    memset(grid, 0, sizeof(sdl_grid));
+    grid->cell_size = cell_size;
+    grid->inv_cell = 1.0f / cell_size;
+}
+
+void sdl_grid_free(sdl_grid* grid) {
+    for (int i = 0; i < grid->capacity; i++) {
+        free(grid->cells[i].items);
+    }
+    free(grid->cells);
+    grid->cells = NULL;
+    grid->capacity = grid->used = 0;
+}
+
+// Table size for a rehash, from the cells that still hold items: the smallest
+// power of two keeping them under a quarter of the slots. A table filled up
+// with tombstones is rebuilt at the same size (or smaller), not doubled.
+static int grid_rehash_capacity(const sdl_grid* grid) {
+    int live = 0;
+    for (int i = 0; i < grid->capacity; i++) {
+        if (grid->cells[i].occupied && grid->cells[i].count > 0) {
+            live++;
+        }
+    }
+    int capacity = GRID_MIN_CAPACITY;
+    while ((live + 1) * 4 > capacity) {
+        capacity *= 2;
+    }
+    return capacity;
+}
+
+// Rehash into a table of `capacity` slots, dropping cells that became empty.
+static bool grid_rehash(sdl_grid* grid, int capacity) {
+    sdl_grid_cell* cells = (sdl_grid_cell*)calloc(capacity, sizeof(sdl_grid_cell));
+    if (!cells) {
+        return false;
+    }
+    int used = 0;
+    for (int i = 0; i < grid->capacity; i++) {
+        sdl_grid_cell* c = &grid->cells[i];
+        if (!c->occupied) {
+            continue;
+        }
+        if (c->count == 0) {
+            free(c->items);
+            continue;
+        }
+        Uint32 slot = cell_hash(c->cx, c->cy) & (Uint32)(capacity - 1);
+        while (cells[slot].occupied) {
+            slot = (slot + 1) & (Uint32)(capacity - 1);
+        }
+        cells[slot] = *c;
+        used++;
+    }
+    free(grid->cells);
+    grid->cells = cells;
+    grid->capacity = capacity;
+    grid->used = used;
+    return true;
+}
+
+static sdl_grid_cell* grid_find(const sdl_grid* grid, int cx, int cy) {
+    if (grid->capacity == 0) {
+        return NULL;
+    }
+    Uint32 mask = (Uint32)(grid->capacity - 1);
+    Uint32 slot = cell_hash(cx, cy) & mask;
+    while (grid->cells[slot].occupied) {
+        sdl_grid_cell* c = &grid->cells[slot];
+        if (c->cx == cx && c->cy == cy) {
+            return c;
+        }
+        slot = (slot + 1) & mask;
+    }
+    return NULL;
+}
+
+static sdl_grid_cell* grid_find_or_add(sdl_grid* grid, int cx, int cy) {
+    if (grid->capacity > 0) {
+        Uint32 mask = (Uint32)(grid->capacity - 1);
+        Uint32 slot = cell_hash(cx, cy) & mask;
+        sdl_grid_cell* tombstone = NULL;
+        while (grid->cells[slot].occupied) {
+            sdl_grid_cell* c = &grid->cells[slot];
+            if (c->cx == cx && c->cy == cy) {
+                return c;
+            }
+            if (!tombstone && c->count == 0) {
+                tombstone = c;
+            }
+            slot = (slot + 1) & mask;
+        }
+        if (tombstone) {
+            // On this key's probe chain, so lookups still find it; keeps its buffer
+            tombstone->cx = cx;
+            tombstone->cy = cy;
+            return tombstone;
+        }
+    }
+    // Keep the load factor (tombstones included) under 1/2
+    if ((grid->used + 1) * 2 > grid->capacity) {
+        if (!grid_rehash(grid, grid_rehash_capacity(grid))) {
+            return NULL;
+        }
+    }
+    Uint32 mask = (Uint32)(grid->capacity - 1);
+    Uint32 slot = cell_hash(cx, cy) & mask;
+    while (grid->cells[slot].occupied) {
+        slot = (slot + 1) & mask;
+    }
+    sdl_grid_cell* c = &grid->cells[slot];
+    c->cx = cx;
+    c->cy = cy;
+    c->occupied = true;
+    grid->used++;
+    return c;
+}
+
+static bool cell_add(sdl_grid_cell* c, int id) {
+    if (c->count == c->capacity) {
+        int capacity = c->capacity > 0 ? c->capacity * 2 : 4;
+        int* items = (int*)realloc(c->items, capacity * sizeof(int));
+        if (!items) {
+            return false;
+        }
+        c->items = items;
+        c->capacity = capacity;
+    }
+    c->items[c->count++] = id;
+    return true;
+}
+
+static void cell_remove(sdl_grid_cell* c, int id) {
+    for (int i = 0; i < c->count; i++) {
+        if (c->items[i] == id) {
+            c->items[i] = c->items[--c->count];
+            return;
+        }
+    }
+}
+
+void sdl_grid_cell_range(const sdl_grid* grid, const SDL_FRect* box, int range[4]) {
+    range[0] = cell_coord(box->x, grid->inv_cell);
+    range[1] = cell_coord(box->y, grid->inv_cell);
+    range[2] = cell_coord(box->x + box->w, grid->inv_cell);
+    range[3] = cell_coord(box->y + box->h, grid->inv_cell);
+}
+
+// A box the grid can store: finite, inside the clamped cell range and
+// covering at most GRID_MAX_ITEM_CELLS cells. Callers check this before
+// changing their own state; insert and move fail on anything else.
+bool sdl_grid_box_valid(const sdl_grid* grid, const SDL_FRect* box) {
+    if (SDL_isinff(box->x) || SDL_isnanf(box->x) || SDL_isinff(box->y) || SDL_isnanf(box->y) ||
+        SDL_isinff(box->w) || SDL_isnanf(box->w) || SDL_isinff(box->h) || SDL_isnanf(box->h)) {
+        return false;
+    }
+    int r[4];
+    sdl_grid_cell_range(grid, box, r);
+    for (int i = 0; i < 4; i++) {
+        if (r[i] <= -GRID_COORD_LIMIT || r[i] >= GRID_COORD_LIMIT) {
+            return false;
+        }
+    }
+    return ((double)r[2] - r[0] + 1.0) * ((double)r[3] - r[1] + 1.0) <= GRID_MAX_ITEM_CELLS;
+}
+
+bool sdl_grid_insert(sdl_grid* grid, int id, const SDL_FRect* box) {
+    if (!sdl_grid_box_valid(grid, box)) {
+        return false;
+    }
+    int r[4];
+    sdl_grid_cell_range(grid, box, r);
+    for (int cy = r[1]; cy <= r[3]; cy++) {
+        for (int cx = r[0]; cx <= r[2]; cx++) {
+            sdl_grid_cell* c = grid_find_or_add(grid, cx, cy);
+            if (!c || !cell_add(c, id)) {
+                sdl_grid_remove(grid, id, box); // out of memory: leave the grid as it was
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+void sdl_grid_remove(sdl_grid* grid, int id, const SDL_FRect* box) {
+    int r[4];
+    sdl_grid_cell_range(grid, box, r);
+    for (int cy = r[1]; cy <= r[3]; cy++) {
+        for (int cx = r[0]; cx <= r[2]; cx++) {
+            sdl_grid_cell* c = grid_find(grid, cx, cy);
+            if (c) {
+                cell_remove(c, id);
+            }
+        }
+    }
+}
+
+// Remove id from the cells of range `from` that are not in range `keep`.
+static void grid_remove_outside(sdl_grid* grid, int id, const int from[4], const int keep[4]) {
+    for (int cy = from[1]; cy <= from[3]; cy++) {
+        for (int cx = from[0]; cx <= from[2]; cx++) {
+            if (cx >= keep[0] && cx <= keep[2] && cy >= keep[1] && cy <= keep[3]) {
+                continue;
+            }
+            sdl_grid_cell* c = grid_find(grid, cx, cy);
+            if (c) {
+                cell_remove(c, id);
+            }
+        }
+    }
+}
+
+// Move an item; only cells entering or leaving its coverage are touched. The
+// new cells are filled first, so on failure the item keeps its old cells.
+bool sdl_grid_move(sdl_grid* grid, int id, const SDL_FRect* old_box, const SDL_FRect* new_box) {
+    if (!sdl_grid_box_valid(grid, new_box)) {
+        return false;
+    }
+    int o[4], n[4];
+    sdl_grid_cell_range(grid, old_box, o);
+    sdl_grid_cell_range(grid, new_box, n);
+    if (memcmp(o, n, sizeof(o)) == 0) {
+        return true;
+    }
+
+    for (int cy = n[1]; cy <= n[3]; cy++) {
+        for (int cx = n[0]; cx <= n[2]; cx++) {
+            if (cx >= o[0] && cx <= o[2] && cy >= o[1] && cy <= o[3]) {
+                continue;
+            }
+            sdl_grid_cell* c = grid_find_or_add(grid, cx, cy);
+            if (!c || !cell_add(c, id)) {
+                grid_remove_outside(grid, id, n, o);
+                return false;
+            }
+        }
+    }
+    grid_remove_outside(grid, id, o, n);
+    return true;
+}
+
+// Call fn for every id stored in a cell touched by box (ids can repeat).
+// A box with NaN coordinates matches nothing; huge boxes scan the table.
+void sdl_grid_query(const sdl_grid* grid, const SDL_FRect* box, sdl_grid_visit fn, void* ctx) {
+    if (SDL_isnanf(box->x) || SDL_isnanf(box->y) || SDL_isnanf(box->w) || SDL_isnanf(box->h)) {
+        return;
+    }
+    int r[4];
+    sdl_grid_cell_range(grid, box, r);
+    double span = ((double)r[2] - r[0] + 1.0) * ((double)r[3] - r[1] + 1.0);
+
+    if (span > (double)grid->used) {
+        // Query covers more cells than exist (zoomed far out): scan the table instead
+        for (int i = 0; i < grid->capacity; i++) {
+            const sdl_grid_cell* c = &grid->cells[i];
+            if (c->occupied && c->count > 0 && c->cx >= r[0] && c->cx <= r[2] && c->cy >= r[1] && c->cy <= r[3]) {
+                for (int k = 0; k < c->count; k++) {
+                    fn(c->items[k], ctx);
+                }
+            }
+        }
+        return;
+    }
+
+    for (int cy = r[1]; cy <= r[3]; cy++) {
+        for (int cx = r[0]; cx <= r[2]; cx++) {
+            const sdl_grid_cell* c = grid_find(grid, cx, cy);
+            if (c) {
+                for (int k = 0; k < c->count; k++) {
+                    fn(c->items[k], ctx);
+                }
+            }
+        }
+    }
+}
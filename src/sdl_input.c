@@ -0,0 +1,312 @@
+// sdl_input.c
+// Keyboard/mouse state snapshot. One persistent userdata holds the held keys
+// and buttons of this frame and the previous one as bit sets, so held/pressed/
+// released queries are O(1) and no event tables are needed.
+#include "module_sdl.h"
+#include <stdio.h>
+#include <string.h>
+
+static const char* INPUT_MT = "sdl.input";
+
+#define INPUT_KEY_WORDS ((SDL_SCANCODE_COUNT + 63) / 64)
+
+typedef struct {
+    Uint64 keys[INPUT_KEY_WORDS];
+    Uint64 prev_keys[INPUT_KEY_WORDS];
+    Uint32 buttons, prev_buttons;
+    float mouse_x, mouse_y;
+    float prev_x, prev_y;
+} lua_SDL_Input;
+
+// Registry key of the singleton
+static int input_key;
+
+// Device state rebuilt from replayed events. SDL_PushEvent does not touch
+// SDL's own keyboard/mouse state, so snapshots read this while replaying.
+static Uint64 replay_keys[INPUT_KEY_WORDS];
+static Uint32 replay_buttons;
+static float replay_x, replay_y;
+
+static lua_SDL_Input* check_input(lua_State* L, int idx) {
+    return (lua_SDL_Input*)luaL_checkudata(L, idx, INPUT_MT);
+}
+
+static inline bool key_bit(const Uint64* bits, int scancode) {
+    return (bits[scancode >> 6] >> (scancode & 63)) & 1;
+}
+
+void sdl_input_apply_event(const SDL_Event* e) {
+    switch (e->type) {
+        case SDL_EVENT_KEY_DOWN:
+        case SDL_EVENT_KEY_UP: {
+            int sc = e->key.scancode;
+            if (sc >= 0 && sc < SDL_SCANCODE_COUNT) {
+                Uint64 bit = (Uint64)1 << (sc & 63);
+                if (e->key.down) {
+                    replay_keys[sc >> 6] |= bit;
+                } else {
+                    replay_keys[sc >> 6] &= ~bit;
+                }
+            }
+            break;
+        }
+        case SDL_EVENT_MOUSE_MOTION:
+            replay_x = e->motion.x;
+            replay_y = e->motion.y;
+            replay_buttons = e->motion.state;
+            break;
+        case SDL_EVENT_MOUSE_BUTTON_DOWN:
+        case SDL_EVENT_MOUSE_BUTTON_UP:
+            replay_x = e->button.x;
+            replay_y = e->button.y;
+            if (e->button.down) {
+                replay_buttons |= SDL_BUTTON_MASK(e->button.button);
+            } else {
+                replay_buttons &= ~SDL_BUTTON_MASK(e->button.button);
+            }
+            break;
+    }
+}
+
+static int check_scancode(lua_State* L, int arg) {
+    lua_Integer sc = luaL_checkinteger(L, arg);
+    if (sc < 0 || sc >= SDL_SCANCODE_COUNT) {
+        luaL_error(L, "Invalid scancode %d", (int)sc);
+    }
+    return (int)sc;
+}
+
+static Uint32 check_button_mask(lua_State* L, int arg) {
+    lua_Integer button = luaL_checkinteger(L, arg);
+    if (button < 1 || button > 32) {
+        luaL_error(L, "Invalid mouse button %d", (int)button);
+    }
+    return SDL_BUTTON_MASK(button);
+}
+
+// Take a new snapshot; the previous one becomes the edge reference.
+static void input_snapshot(lua_SDL_Input* in) {
+    memcpy(in->prev_keys, in->keys, sizeof(in->keys));
+    in->prev_buttons = in->buttons;
+    in->prev_x = in->mouse_x;
+    in->prev_y = in->mouse_y;
+
+    if (sdl_replay_active()) {
+        memcpy(in->keys, replay_keys, sizeof(in->keys));
+        in->buttons = replay_buttons;
+        in->mouse_x = replay_x;
+        in->mouse_y = replay_y;
+        return;
+    }
+
+    int numkeys = 0;
+    const bool* state = SDL_GetKeyboardState(&numkeys);
+    if (numkeys > SDL_SCANCODE_COUNT) numkeys = SDL_SCANCODE_COUNT;
+    memset(in->keys, 0, sizeof(in->keys));
+    for (int i = 0; i < numkeys; i++) {
+        if (state[i]) {
+            in->keys[i >> 6] |= (Uint64)1 << (i & 63);
+        }
+    }
+    in->buttons = SDL_GetMouseState(&in->mouse_x, &in->mouse_y);
+}
+
+// input[scancode] -> held; input.x / input.y / input.dx / input.dy -> mouse
+static int input_index(lua_State* L) {
+    lua_SDL_Input* in = check_input(L, 1);
+    if (lua_type(L, 2) == LUA_TNUMBER) {
+        lua_Integer sc = lua_tointeger(L, 2);
+        lua_pushboolean(L, sc >= 0 && sc < SDL_SCANCODE_COUNT && key_bit(in->keys, (int)sc));
+        return 1;
+    }
+
+    const char* key = luaL_checkstring(L, 2);
+    if (strcmp(key, "x") == 0) {
+        lua_pushnumber(L, in->mouse_x);
+    } else if (strcmp(key, "y") == 0) {
+        lua_pushnumber(L, in->mouse_y);
+    } else if (strcmp(key, "dx") == 0) {
+        lua_pushnumber(L, in->mouse_x - in->prev_x);
+    } else if (strcmp(key, "dy") == 0) {
+        lua_pushnumber(L, in->mouse_y - in->prev_y);
+    } else if (strcmp(key, "buttons") == 0) {
+        lua_pushinteger(L, in->buttons);
+    } else {
+        lua_pushnil(L);
+    }
+    return 1;
+}
+
+// Get the input snapshot (same userdata every call): sdl.get_input()
+static int l_sdl_get_input(lua_State* L) {
+    lua_rawgetp(L, LUA_REGISTRYINDEX, &input_key);
+    if (!lua_isnil(L, -1)) {
+        return 1;
+    }
+    lua_pop(L, 1);
+
+    lua_SDL_Input* in = (lua_SDL_Input*)lua_newuserdata(L, sizeof(lua_SDL_Input));
+    memset(in, 0, sizeof(lua_SDL_Input));
+    luaL_setmetatable(L, INPUT_MT);
+    input_snapshot(in);
+    input_snapshot(in); // no edges on the first frame
+    lua_pushvalue(L, -1);
+    lua_rawsetp(L, LUA_REGISTRYINDEX, &input_key);
+    return 1;
+}
+
+// Snapshot keyboard/mouse state for this frame: sdl.update_input(input, [drain]) -> quit_requested
+// Pumps events itself; with drain = true the keyboard/mouse events are removed
+// from the queue for scripts that never call poll_events. Recordings of such
+// scripts should use drain, so events are recorded in the frame they apply to.
+static int l_sdl_update_input(lua_State* L) {
+    lua_SDL_Input* in = check_input(L, 1);
+    bool drain = lua_toboolean(L, 2);
+
+    sdl_reload_poll(L);
+    if (!sdl_replay_begin_pump()) {
+        luaL_error(L, "Failed to push replayed events: %s", SDL_GetError());
+    }
+    SDL_PumpEvents();
+    input_snapshot(in);
+
+    if (drain) {
+        // Taken one by one so a running recording still sees them
+        SDL_Event e;
+        while (SDL_PeepEvents(&e, 1, SDL_GETEVENT, SDL_EVENT_KEY_DOWN, SDL_EVENT_KEY_UP) > 0 ||
+               SDL_PeepEvents(&e, 1, SDL_GETEVENT, SDL_EVENT_MOUSE_MOTION, SDL_EVENT_MOUSE_WHEEL) > 0) {
+            sdl_replay_accept_event(&e);
+        }
+        SDL_FlushEvents(SDL_EVENT_TEXT_EDITING, SDL_EVENT_TEXT_INPUT);
+    }
+    lua_pushboolean(L, SDL_HasEvent(SDL_EVENT_QUIT) || SDL_HasEvent(SDL_EVENT_WINDOW_CLOSE_REQUESTED));
+    return 1;
+}
+
+// Held this frame: sdl.key_down(input, scancode)
+static int l_sdl_key_down(lua_State* L) {
+    lua_SDL_Input* in = check_input(L, 1);
+    int sc = check_scancode(L, 2);
+    lua_pushboolean(L, key_bit(in->keys, sc));
+    return 1;
+}
+
+// Went down since the last update: sdl.key_pressed(input, scancode)
+static int l_sdl_key_pressed(lua_State* L) {
+    lua_SDL_Input* in = check_input(L, 1);
+    int sc = check_scancode(L, 2);
+    lua_pushboolean(L, key_bit(in->keys, sc) && !key_bit(in->prev_keys, sc));
+    return 1;
+}
+
+// Went up since the last update: sdl.key_released(input, scancode)
+static int l_sdl_key_released(lua_State* L) {
+    lua_SDL_Input* in = check_input(L, 1);
+    int sc = check_scancode(L, 2);
+    lua_pushboolean(L, !key_bit(in->keys, sc) && key_bit(in->prev_keys, sc));
+    return 1;
+}
+
+// sdl.mouse_down(input, button)
+static int l_sdl_mouse_down(lua_State* L) {
+    lua_SDL_Input* in = check_input(L, 1);
+    Uint32 mask = check_button_mask(L, 2);
+    lua_pushboolean(L, (in->buttons & mask) != 0);
+    return 1;
+}
+
+// sdl.mouse_pressed(input, button)
+static int l_sdl_mouse_pressed(lua_State* L) {
+    lua_SDL_Input* in = check_input(L, 1);
+    Uint32 mask = check_button_mask(L, 2);
+    lua_pushboolean(L, (in->buttons & ~in->prev_buttons & mask) != 0);
+    return 1;
+}
+
+// sdl.mouse_released(input, button)
+static int l_sdl_mouse_released(lua_State* L) {
+    lua_SDL_Input* in = check_input(L, 1);
+    Uint32 mask = check_button_mask(L, 2);
+    lua_pushboolean(L, (~in->buttons & in->prev_buttons & mask) != 0);
+    return 1;
+}
+
+// Mouse position and motion since the last update: sdl.mouse_position(input) -> x, y, dx, dy
+static int l_sdl_mouse_position(lua_State* L) {
+    lua_SDL_Input* in = check_input(L, 1);
+    lua_pushnumber(L, in->mouse_x);
+    lua_pushnumber(L, in->mouse_y);
+    lua_pushnumber(L, in->mouse_x - in->prev_x);
+    lua_pushnumber(L, in->mouse_y - in->prev_y);
+    return 4;
+}
+
+// Look up a scancode by name ("Left Shift", "F1", ...): sdl.get_scancode_from_name(name)
+static int l_sdl_get_scancode_from_name(lua_State* L) {
+    const char* name = luaL_checkstring(L, 1);
+    lua_pushinteger(L, SDL_GetScancodeFromName(name));
+    return 1;
+}
+
+static const struct luaL_Reg input_lib[] = {
+    {"get_input", l_sdl_get_input},
+    {"update_input", l_sdl_update_input},
+    {"key_down", l_sdl_key_down},
+    {"key_pressed", l_sdl_key_pressed},
+    {"key_released", l_sdl_key_released},
+    {"mouse_down", l_sdl_mouse_down},
+    {"mouse_pressed", l_sdl_mouse_pressed},
+    {"mouse_released", l_sdl_mouse_released},
+    {"mouse_position", l_sdl_mouse_position},
+    {"get_scancode_from_name", l_sdl_get_scancode_from_name},
+    {NULL, NULL}
+};
+
+// Create the input metatable, add the input functions and SCANCODE_* constants.
+void sdl_input_register(lua_State* L) {
+    luaL_newmetatable(L, INPUT_MT);
+    lua_pushcfunction(L, input_index);
+    lua_setfield(L, -2, "__index");
+    lua_pop(L, 1);
+
+    luaL_setfuncs(L, input_lib, 0);
+
+    // Letters and digits are contiguous in SDL_Scancode
+    char name[32];
+    for (int i = 0; i < 26; i++) {
+        snprintf(name, sizeof(name), "SCANCODE_%c", 'A' + i);
+        lua_pushinteger(L, SDL_SCANCODE_A + i);
+        lua_setfield(L, -2, name);
+    }
+    for (int i = 0; i < 10; i++) {
+        snprintf(name, sizeof(name), "SCANCODE_%d", (i + 1) % 10);
+        lua_pushinteger(L, SDL_SCANCODE_1 + i);
+        lua_setfield(L, -2, name);
+    }
+
+    lua_pushinteger(L, SDL_SCANCODE_RETURN);
+    lua_setfield(L, -2, "SCANCODE_RETURN");
+    lua_pushinteger(L, SDL_SCANCODE_ESCAPE);
+    lua_setfield(L, -2, "SCANCODE_ESCAPE");
+    lua_pushinteger(L, SDL_SCANCODE_SPACE);
+    lua_setfield(L, -2, "SCANCODE_SPACE");
+    lua_pushinteger(L, SDL_SCANCODE_TAB);
+    lua_setfield(L, -2, "SCANCODE_TAB");
+    lua_pushinteger(L, SDL_SCANCODE_LEFT);
+    lua_setfield(L, -2, "SCANCODE_LEFT");
+    lua_pushinteger(L, SDL_SCANCODE_RIGHT);
+    lua_setfield(L, -2, "SCANCODE_RIGHT");
+    lua_pushinteger(L, SDL_SCANCODE_UP);
+    lua_setfield(L, -2, "SCANCODE_UP");
+    lua_pushinteger(L, SDL_SCANCODE_DOWN);
+    lua_setfield(L, -2, "SCANCODE_DOWN");
+    lua_pushinteger(L, SDL_SCANCODE_LSHIFT);
+    lua_setfield(L, -2, "SCANCODE_LSHIFT");
+    lua_pushinteger(L, SDL_SCANCODE_LCTRL);
+    lua_setfield(L, -2, "SCANCODE_LCTRL");
+
+    lua_pushinteger(L, SDL_BUTTON_X1);
+    lua_setfield(L, -2, "BUTTON_X1");
+    lua_pushinteger(L, SDL_BUTTON_X2);
+    lua_setfield(L, -2, "BUTTON_X2");
+}
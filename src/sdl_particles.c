@@ -0,0 +1,359 @@
+// sdl_particles.c
+// Particle emitters with structure-of-arrays storage. The update step
+// integrates gravity, velocity and lifetime four particles at a time and
+// computes each particle's color fade; dead particles are swap-removed.
+// render_particles writes one quad per particle straight into the renderer's
+// geometry batch.
+#include "module_sdl.h"
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define SDL_PARTICLES_SSE2 1
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define SDL_PARTICLES_NEON 1
+#endif
+
+static const char* PARTICLES_MT = "sdl.particles";
+
+// Quads handed to the batch per allocation, keeps single allocations bounded
+#define PARTICLE_CHUNK 16384
+
+// Emission settings; options are parsed into a copy and only stored once valid
+typedef struct {
+    float life_min, life_max;
+    float speed_min, speed_max;
+    float angle, spread; // radians: direction and full cone width
+    float gravity_x, gravity_y;
+    float size;
+    SDL_FColor start_color, end_color;
+} particle_emission;
+
+typedef struct {
+    // SoA storage, `capacity` floats each, one allocation
+    float* x;
+    float* y;
+    float* vx;
+    float* vy;
+    float* life;     // seconds left
+    float* inv_life; // 1 / total lifetime
+    float* fade;     // life * inv_life, 1 at birth -> 0 at death
+    int count;
+    int capacity;
+
+    particle_emission emit;
+    Uint32 rng;
+} lua_SDL_Particles;
+
+static lua_SDL_Particles* check_particles(lua_State* L, int idx) {
+    return (lua_SDL_Particles*)luaL_checkudata(L, idx, PARTICLES_MT);
+}
+
+// xorshift32, uniform in [0, 1)
+static inline float rng_float(Uint32* state) {
+    Uint32 s = *state;
+    s ^= s << 13;
+    s ^= s >> 17;
+    s ^= s << 5;
+    *state = s;
+    return (float)(s >> 8) * (1.0f / 16777216.0f);
+}
+
+static int particles_gc(lua_State* L) {
+    lua_SDL_Particles* p = check_particles(L, 1);
+    free(p->x);
+    p->x = NULL;
+    p->count = p->capacity = 0;
+    return 0;
+}
+
+// Read an {r, g, b, [a]} table of 0-255 values.
+static SDL_FColor read_color(lua_State* L, int idx, SDL_FColor def) {
+    if (lua_isnil(L, idx)) {
+        return def;
+    }
+    luaL_checktype(L, idx, LUA_TTABLE);
+    float c[4] = { def.r * 255.0f, def.g * 255.0f, def.b * 255.0f, def.a * 255.0f };
+    for (int i = 0; i < 4; i++) {
+        lua_rawgeti(L, idx, i + 1);
+        c[i] = (float)luaL_optnumber(L, -1, c[i]);
+        lua_pop(L, 1);
+    }
+    SDL_FColor color = { c[0] / 255.0f, c[1] / 255.0f, c[2] / 255.0f, c[3] / 255.0f };
+    return color;
+}
+
+static float opt_field(lua_State* L, int idx, const char* name, float def) {
+    lua_getfield(L, idx, name);
+    float v = (float)luaL_optnumber(L, -1, def);
+    lua_pop(L, 1);
+    return v;
+}
+
+// Apply the emission fields present in an options table. Fields are read into
+// a copy and checked before anything is stored, so an error (a bad field or a
+// lifetime range that does not hold) leaves the emitter unchanged.
+static void read_options(lua_State* L, int idx, lua_SDL_Particles* p) {
+    particle_emission e = p->emit;
+    e.life_min = opt_field(L, idx, "life_min", e.life_min);
+    e.life_max = opt_field(L, idx, "life_max", e.life_max);
+    e.speed_min = opt_field(L, idx, "speed_min", e.speed_min);
+    e.speed_max = opt_field(L, idx, "speed_max", e.speed_max);
+    e.angle = opt_field(L, idx, "angle", e.angle);
+    e.spread = opt_field(L, idx, "spread", e.spread);
+    e.gravity_x = opt_field(L, idx, "gravity_x", e.gravity_x);
+    e.gravity_y = opt_field(L, idx, "gravity_y", e.gravity_y);
+    e.size = opt_field(L, idx, "size", e.size);
+
+    lua_getfield(L, idx, "start_color");
+    e.start_color = read_color(L, -1, e.start_color);
+    lua_pop(L, 1);
+    lua_getfield(L, idx, "end_color");
+    e.end_color = read_color(L, -1, e.end_color);
+    lua_pop(L, 1);
+
+    Uint32 rng = p->rng;
+    lua_getfield(L, idx, "seed");
+    if (!lua_isnil(L, -1)) {
+        Uint32 seed = (Uint32)luaL_checkinteger(L, -1);
+        rng = seed ? seed : 1; // xorshift state must not be 0
+    }
+    lua_pop(L, 1);
+
+    if (!(e.life_min > 0.0f) || !(e.life_max >= e.life_min)) {
+        luaL_error(L, "Particle lifetime must satisfy 0 < life_min <= life_max");
+    }
+    p->emit = e;
+    p->rng = rng;
+}
+
+// Create an emitter: sdl.create_particles({capacity = 10000, life_min, life_max,
+//     speed_min, speed_max, angle, spread, gravity_x, gravity_y, size,
+//     start_color = {r, g, b, a}, end_color = {r, g, b, a}, seed})
+static int l_sdl_create_particles(lua_State* L) {
+    luaL_checktype(L, 1, LUA_TTABLE);
+    lua_getfield(L, 1, "capacity");
+    lua_Integer capacity = luaL_optinteger(L, -1, 10000);
+    lua_pop(L, 1);
+    if (capacity < 1 || capacity > 16 * 1024 * 1024) {
+        luaL_error(L, "Invalid particle capacity %d", (int)capacity);
+    }
+
+    lua_SDL_Particles* p = (lua_SDL_Particles*)lua_newuserdata(L, sizeof(lua_SDL_Particles));
+    memset(p, 0, sizeof(lua_SDL_Particles));
+    luaL_setmetatable(L, PARTICLES_MT);
+
+    p->emit.life_min = p->emit.life_max = 1.0f;
+    p->emit.speed_min = 0.0f;
+    p->emit.speed_max = 100.0f;
+    p->emit.spread = 2.0f * SDL_PI_F;
+    p->emit.size = 4.0f;
+    p->emit.start_color = (SDL_FColor){ 1.0f, 1.0f, 1.0f, 1.0f };
+    p->emit.end_color = (SDL_FColor){ 1.0f, 1.0f, 1.0f, 0.0f };
+    p->rng = 0x9E3779B9u;
+    read_options(L, 1, p);
+
+    float* block = (float*)malloc((size_t)capacity * 7 * sizeof(float));
+    if (!block) {
+        luaL_error(L, "Failed to allocate %d particles", (int)capacity);
+    }
+    p->capacity = (int)capacity;
+    p->x = block;
+    p->y = block + capacity;
+    p->vx = block + capacity * 2;
+    p->vy = block + capacity * 3;
+    p->life = block + capacity * 4;
+    p->inv_life = block + capacity * 5;
+    p->fade = block + capacity * 6;
+    return 1;
+}
+
+// Change emission settings (same fields as create_particles): sdl.particles_set(emitter, options)
+static int l_sdl_particles_set(lua_State* L) {
+    lua_SDL_Particles* p = check_particles(L, 1);
+    luaL_checktype(L, 2, LUA_TTABLE);
+    read_options(L, 2, p);
+    return 0;
+}
+
+// Spawn particles at a point: sdl.emit_particles(emitter, count, x, y) -> spawned
+static int l_sdl_emit_particles(lua_State* L) {
+    lua_SDL_Particles* p = check_particles(L, 1);
+    lua_Integer count = luaL_checkinteger(L, 2);
+    float x = (float)luaL_checknumber(L, 3);
+    float y = (float)luaL_checknumber(L, 4);
+
+    int room = p->capacity - p->count;
+    int n = count < 0 ? 0 : (count > room ? room : (int)count);
+    for (int k = 0; k < n; k++) {
+        int i = p->count++;
+        float angle = p->emit.angle + (rng_float(&p->rng) - 0.5f) * p->emit.spread;
+        float speed = p->emit.speed_min + (p->emit.speed_max - p->emit.speed_min) * rng_float(&p->rng);
+        float life = p->emit.life_min + (p->emit.life_max - p->emit.life_min) * rng_float(&p->rng);
+        p->x[i] = x;
+        p->y[i] = y;
+        p->vx[i] = SDL_cosf(angle) * speed;
+        p->vy[i] = SDL_sinf(angle) * speed;
+        p->life[i] = life;
+        p->inv_life[i] = 1.0f / life;
+        p->fade[i] = 1.0f;
+    }
+    lua_pushinteger(L, n);
+    return 1;
+}
+
+// Integrate every particle and compute its fade; the caller removes the dead.
+static void integrate(lua_SDL_Particles* p, float dt) {
+    const float gdx = p->emit.gravity_x * dt, gdy = p->emit.gravity_y * dt;
+    int n = p->count;
+    int i = 0;
+
+#if defined(SDL_PARTICLES_SSE2)
+    const __m128 vdt = _mm_set1_ps(dt);
+    const __m128 vgx = _mm_set1_ps(gdx), vgy = _mm_set1_ps(gdy);
+    const __m128 zero = _mm_setzero_ps();
+    for (; i + 4 <= n; i += 4) {
+        __m128 vx = _mm_add_ps(_mm_loadu_ps(p->vx + i), vgx);
+        __m128 vy = _mm_add_ps(_mm_loadu_ps(p->vy + i), vgy);
+        _mm_storeu_ps(p->vx + i, vx);
+        _mm_storeu_ps(p->vy + i, vy);
+        _mm_storeu_ps(p->x + i, _mm_add_ps(_mm_loadu_ps(p->x + i), _mm_mul_ps(vx, vdt)));
+        _mm_storeu_ps(p->y + i, _mm_add_ps(_mm_loadu_ps(p->y + i), _mm_mul_ps(vy, vdt)));
+        __m128 life = _mm_sub_ps(_mm_loadu_ps(p->life + i), vdt);
+        _mm_storeu_ps(p->life + i, life);
+        _mm_storeu_ps(p->fade + i, _mm_mul_ps(_mm_max_ps(life, zero), _mm_loadu_ps(p->inv_life + i)));
+    }
+#elif defined(SDL_PARTICLES_NEON)
+    const float32x4_t vdt = vdupq_n_f32(dt);
+    const float32x4_t vgx = vdupq_n_f32(gdx), vgy = vdupq_n_f32(gdy);
+    const float32x4_t zero = vdupq_n_f32(0.0f);
+    for (; i + 4 <= n; i += 4) {
+        float32x4_t vx = vaddq_f32(vld1q_f32(p->vx + i), vgx);
+        float32x4_t vy = vaddq_f32(vld1q_f32(p->vy + i), vgy);
+        vst1q_f32(p->vx + i, vx);
+        vst1q_f32(p->vy + i, vy);
+        vst1q_f32(p->x + i, vmlaq_f32(vld1q_f32(p->x + i), vx, vdt));
+        vst1q_f32(p->y + i, vmlaq_f32(vld1q_f32(p->y + i), vy, vdt));
+        float32x4_t life = vsubq_f32(vld1q_f32(p->life + i), vdt);
+        vst1q_f32(p->life + i, life);
+        vst1q_f32(p->fade + i, vmulq_f32(vmaxq_f32(life, zero), vld1q_f32(p->inv_life + i)));
+    }
+#endif
+
+    for (; i < n; i++) {
+        p->vx[i] += gdx;
+        p->vy[i] += gdy;
+        p->x[i] += p->vx[i] * dt;
+        p->y[i] += p->vy[i] * dt;
+        p->life[i] -= dt;
+        p->fade[i] = (p->life[i] > 0.0f ? p->life[i] : 0.0f) * p->inv_life[i];
+    }
+}
+
+// Advance all particles by dt seconds: sdl.update_particles(emitter, dt) -> alive
+static int l_sdl_update_particles(lua_State* L) {
+    lua_SDL_Particles* p = check_particles(L, 1);
+    float dt = (float)luaL_checknumber(L, 2);
+
+    integrate(p, dt);
+
+    // Swap-remove the dead; order does not matter for additive-style effects
+    int i = 0;
+    while (i < p->count) {
+        if (p->life[i] > 0.0f) {
+            i++;
+            continue;
+        }
+        int last = --p->count;
+        p->x[i] = p->x[last];
+        p->y[i] = p->y[last];
+        p->vx[i] = p->vx[last];
+        p->vy[i] = p->vy[last];
+        p->life[i] = p->life[last];
+        p->inv_life[i] = p->inv_life[last];
+        p->fade[i] = p->fade[last];
+    }
+    lua_pushinteger(L, p->count);
+    return 1;
+}
+
+// Live particles: sdl.particle_count(emitter)
+static int l_sdl_particle_count(lua_State* L) {
+    lua_pushinteger(L, check_particles(L, 1)->count);
+    return 1;
+}
+
+// Remove every particle: sdl.clear_particles(emitter)
+static int l_sdl_clear_particles(lua_State* L) {
+    check_particles(L, 1)->count = 0;
+    return 0;
+}
+
+// Draw the particles as quads through the renderer batch:
+// sdl.render_particles(renderer, emitter, [texture])
+static int l_sdl_render_particles(lua_State* L) {
+    lua_SDL_Renderer* ud = lua_check_SDL_Renderer(L, 1);
+    lua_SDL_Particles* p = check_particles(L, 2);
+    SDL_Texture* texture = NULL;
+    if (!lua_isnoneornil(L, 3)) {
+        texture = lua_check_SDL_Texture(L, 3)->texture;
+    }
+
+    if (!ud->renderer) {
+        luaL_error(L, "No renderer available");
+    }
+
+    const float h = p->emit.size * 0.5f;
+    const SDL_FColor e = p->emit.end_color;
+    const SDL_FColor d = { p->emit.start_color.r - e.r, p->emit.start_color.g - e.g,
+                           p->emit.start_color.b - e.b, p->emit.start_color.a - e.a };
+
+    for (int first = 0; first < p->count; first += PARTICLE_CHUNK) {
+        int n = p->count - first < PARTICLE_CHUNK ? p->count - first : PARTICLE_CHUNK;
+        int* indices;
+        int base;
+        SDL_Vertex* v = sdl_batch_alloc(L, ud, texture, n * 4, n * 6, &indices, &base);
+
+        for (int k = 0; k < n; k++, v += 4, indices += 6) {
+            int i = first + k;
+            float f = p->fade[i];
+            SDL_FColor c = { e.r + d.r * f, e.g + d.g * f, e.b + d.b * f, e.a + d.a * f };
+            float x0 = p->x[i] - h, y0 = p->y[i] - h;
+            float x1 = p->x[i] + h, y1 = p->y[i] + h;
+
+            v[0].position.x = x0; v[0].position.y = y0; v[0].tex_coord.x = 0.0f; v[0].tex_coord.y = 0.0f;
+            v[1].position.x = x1; v[1].position.y = y0; v[1].tex_coord.x = 1.0f; v[1].tex_coord.y = 0.0f;
+            v[2].position.x = x1; v[2].position.y = y1; v[2].tex_coord.x = 1.0f; v[2].tex_coord.y = 1.0f;
+            v[3].position.x = x0; v[3].position.y = y1; v[3].tex_coord.x = 0.0f; v[3].tex_coord.y = 1.0f;
+            v[0].color = v[1].color = v[2].color = v[3].color = c;
+
+            int q = base + k * 4;
+            indices[0] = q;     indices[1] = q + 1; indices[2] = q + 2;
+            indices[3] = q;     indices[4] = q + 2; indices[5] = q + 3;
+        }
+    }
+    return 0;
+}
+
+static const struct luaL_Reg particles_lib[] = {
+    {"create_particles", l_sdl_create_particles},
+    {"particles_set", l_sdl_particles_set},
+    {"emit_particles", l_sdl_emit_particles},
+    {"update_particles", l_sdl_update_particles},
+    {"particle_count", l_sdl_particle_count},
+    {"clear_particles", l_sdl_clear_particles},
+    {"render_particles", l_sdl_render_particles},
+    {NULL, NULL}
+};
+
+// Create the particles metatable and add the particle functions.
+void sdl_particles_register(lua_State* L) {
+    luaL_newmetatable(L, PARTICLES_MT);
+    lua_pushcfunction(L, particles_gc);
+    lua_setfield(L, -2, "__gc");
+    lua_pop(L, 1);
+
+    luaL_setfuncs(L, particles_lib, 0);
+}
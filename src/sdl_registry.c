@@ -0,0 +1,572 @@
+// sdl_registry.c
+// Entity/component store. Entities are integer handles (generation << 32 |
+// index) so stale handles are detected after an entity is destroyed and its
+// slot reused. Each component type is a sparse set: a dense array of packed
+// component data plus the owning entity of each element, and a sparse array
+// from entity index to dense position. Systems (integrate, render) walk the
+// dense arrays in C; Lua sees only handles and query iterators.
+#include "module_sdl.h"
+#include <stdlib.h>
+#include <string.h>
+
+static const char* REGISTRY_MT = "sdl.registry";
+
+enum {
+    COMPONENT_POSITION = 1 << 0,
+    COMPONENT_VELOCITY = 1 << 1,
+    COMPONENT_COLOR = 1 << 2,
+    COMPONENT_SPRITE = 1 << 3,
+    COMPONENT_ALL = (1 << 4) - 1
+};
+#define COMPONENT_TYPES 4
+
+typedef struct { float x, y; } position_component;
+typedef struct { float vx, vy; } velocity_component;
+typedef struct {
+    float w, h;
+    int texture;           // slot in the registry texture list, 0 = untextured
+    float u0, v0, u1, v1;
+} sprite_component;
+
+typedef struct {
+    int* sparse;     // entity index -> dense position, -1 if absent
+    Uint32* entity;  // dense position -> entity index
+    void* data;      // dense component data
+    size_t elem_size;
+    int count;
+    int capacity;
+} sparse_set;
+
+typedef struct {
+    Uint32* generation; // per entity slot, bumped on destroy
+    Uint8* mask;        // components present, plus ENTITY_ALIVE
+    int slots;          // entity slots in use (alive or free)
+    int slot_capacity;
+    Uint32* free_slots;
+    int free_count;
+    int alive;
+    sparse_set sets[COMPONENT_TYPES];
+    SDL_Texture** textures; // sprite textures; the userdata live in the uservalue table
+    int texture_count;
+    int* draw_order; // render scratch: sprite positions bucketed by texture
+    int* bucket;     // render scratch: texture_count + 2 bucket offsets
+    int draw_capacity, bucket_capacity;
+} lua_SDL_Registry;
+
+#define ENTITY_ALIVE 0x80
+
+static lua_SDL_Registry* check_registry(lua_State* L, int idx) {
+    return (lua_SDL_Registry*)luaL_checkudata(L, idx, REGISTRY_MT);
+}
+
+static inline lua_Integer make_handle(Uint32 generation, Uint32 index) {
+    return (lua_Integer)(((Uint64)generation << 32) | index);
+}
+
+// Resolve a handle to its entity index, erroring on stale or invalid handles.
+static Uint32 check_entity(lua_State* L, lua_SDL_Registry* reg, int arg) {
+    lua_Integer handle = luaL_checkinteger(L, arg);
+    Uint32 index = (Uint32)((Uint64)handle & 0xffffffffu);
+    Uint32 generation = (Uint32)((Uint64)handle >> 32);
+    if (index >= (Uint32)reg->slots || !(reg->mask[index] & ENTITY_ALIVE) || reg->generation[index] != generation) {
+        luaL_error(L, "Invalid or destroyed entity %I", handle);
+    }
+    return index;
+}
+
+static int set_index(Uint8 component) {
+    switch (component) {
+        case COMPONENT_POSITION: return 0;
+        case COMPONENT_VELOCITY: return 1;
+        case COMPONENT_COLOR: return 2;
+        default: return 3;
+    }
+}
+
+static void* set_get(sparse_set* set, Uint32 entity) {
+    int d = set->sparse[entity];
+    return d < 0 ? NULL : (Uint8*)set->data + (size_t)d * set->elem_size;
+}
+
+// Add (or find) the component of an entity; returns its data slot.
+static void* set_add(lua_State* L, lua_SDL_Registry* reg, Uint8 component, Uint32 entity) {
+    sparse_set* set = &reg->sets[set_index(component)];
+    void* existing = set_get(set, entity);
+    if (existing) {
+        return existing;
+    }
+    if (set->count == set->capacity) {
+        int capacity = set->capacity > 0 ? set->capacity * 2 : 64;
+        Uint32* owners = (Uint32*)realloc(set->entity, capacity * sizeof(Uint32));
+        if (owners) {
+            set->entity = owners;
+        }
+        void* data = owners ? realloc(set->data, capacity * set->elem_size) : NULL;
+        if (!data) {
+            luaL_error(L, "Failed to allocate component storage");
+        }
+        set->data = data;
+        set->capacity = capacity;
+    }
+    int d = set->count++;
+    set->entity[d] = entity;
+    set->sparse[entity] = d;
+    reg->mask[entity] |= component;
+    return (Uint8*)set->data + (size_t)d * set->elem_size;
+}
+
+static void set_remove(lua_SDL_Registry* reg, Uint8 component, Uint32 entity) {
+    sparse_set* set = &reg->sets[set_index(component)];
+    int d = set->sparse[entity];
+    if (d < 0) {
+        return;
+    }
+    int last = --set->count;
+    if (d != last) {
+        Uint32 moved = set->entity[last];
+        memcpy((Uint8*)set->data + (size_t)d * set->elem_size,
+               (Uint8*)set->data + (size_t)last * set->elem_size, set->elem_size);
+        set->entity[d] = moved;
+        set->sparse[moved] = d;
+    }
+    set->sparse[entity] = -1;
+    reg->mask[entity] &= (Uint8)~component;
+}
+
+static int registry_gc(lua_State* L) {
+    lua_SDL_Registry* reg = check_registry(L, 1);
+    for (int i = 0; i < COMPONENT_TYPES; i++) {
+        free(reg->sets[i].sparse);
+        free(reg->sets[i].entity);
+        free(reg->sets[i].data);
+    }
+    free(reg->generation);
+    free(reg->mask);
+    free(reg->free_slots);
+    free(reg->textures);
+    free(reg->draw_order);
+    free(reg->bucket);
+    memset(reg, 0, sizeof(lua_SDL_Registry));
+    return 0;
+}
+
+// Create an empty registry: sdl.create_registry()
+static int l_sdl_create_registry(lua_State* L) {
+    lua_SDL_Registry* reg = (lua_SDL_Registry*)lua_newuserdata(L, sizeof(lua_SDL_Registry));
+    memset(reg, 0, sizeof(lua_SDL_Registry));
+    luaL_setmetatable(L, REGISTRY_MT);
+    reg->sets[0].elem_size = sizeof(position_component);
+    reg->sets[1].elem_size = sizeof(velocity_component);
+    reg->sets[2].elem_size = sizeof(SDL_FColor);
+    reg->sets[3].elem_size = sizeof(sprite_component);
+
+    lua_newtable(L); // sprite textures, kept alive by slot
+    lua_setuservalue(L, -2);
+    return 1;
+}
+
+// Grow the per-entity arrays (and every sparse array) to hold one more slot.
+static void grow_slots(lua_State* L, lua_SDL_Registry* reg) {
+    int capacity = reg->slot_capacity > 0 ? reg->slot_capacity * 2 : 256;
+    Uint32* generation = (Uint32*)realloc(reg->generation, capacity * sizeof(Uint32));
+    if (generation) reg->generation = generation;
+    Uint8* mask = generation ? (Uint8*)realloc(reg->mask, capacity) : NULL;
+    if (mask) reg->mask = mask;
+    Uint32* free_slots = mask ? (Uint32*)realloc(reg->free_slots, capacity * sizeof(Uint32)) : NULL;
+    if (free_slots) reg->free_slots = free_slots;
+    if (!free_slots) {
+        luaL_error(L, "Failed to allocate entity storage");
+    }
+    for (int i = 0; i < COMPONENT_TYPES; i++) {
+        int* sparse = (int*)realloc(reg->sets[i].sparse, capacity * sizeof(int));
+        if (!sparse) {
+            luaL_error(L, "Failed to allocate entity storage");
+        }
+        memset(sparse + reg->slot_capacity, 0xff, (capacity - reg->slot_capacity) * sizeof(int));
+        reg->sets[i].sparse = sparse;
+    }
+    reg->slot_capacity = capacity;
+}
+
+// Create an entity: sdl.create_entity(registry) -> handle
+static int l_sdl_create_entity(lua_State* L) {
+    lua_SDL_Registry* reg = check_registry(L, 1);
+    Uint32 index;
+    if (reg->free_count > 0) {
+        index = reg->free_slots[--reg->free_count];
+    } else {
+        if (reg->slots == reg->slot_capacity) {
+            grow_slots(L, reg);
+        }
+        index = (Uint32)reg->slots++;
+        reg->generation[index] = 1;
+    }
+    reg->mask[index] = ENTITY_ALIVE;
+    reg->alive++;
+    lua_pushinteger(L, make_handle(reg->generation[index], index));
+    return 1;
+}
+
+// Destroy an entity and its components: sdl.destroy_entity(registry, entity)
+static int l_sdl_destroy_entity(lua_State* L) {
+    lua_SDL_Registry* reg = check_registry(L, 1);
+    Uint32 index = check_entity(L, reg, 2);
+    for (int i = 0; i < COMPONENT_TYPES; i++) {
+        set_remove(reg, (Uint8)(1 << i), index);
+    }
+    reg->mask[index] = 0;
+    reg->generation[index]++; // old handles go stale
+    reg->free_slots[reg->free_count++] = index;
+    reg->alive--;
+    return 0;
+}
+
+// sdl.entity_valid(registry, entity) -> bool
+static int l_sdl_entity_valid(lua_State* L) {
+    lua_SDL_Registry* reg = check_registry(L, 1);
+    lua_Integer handle = luaL_checkinteger(L, 2);
+    Uint32 index = (Uint32)((Uint64)handle & 0xffffffffu);
+    Uint32 generation = (Uint32)((Uint64)handle >> 32);
+    lua_pushboolean(L, index < (Uint32)reg->slots && (reg->mask[index] & ENTITY_ALIVE) &&
+                       reg->generation[index] == generation);
+    return 1;
+}
+
+// sdl.entity_count(registry) -> alive entities
+static int l_sdl_entity_count(lua_State* L) {
+    lua_pushinteger(L, check_registry(L, 1)->alive);
+    return 1;
+}
+
+// sdl.entity_set_position(registry, entity, x, y)
+static int l_sdl_entity_set_position(lua_State* L) {
+    lua_SDL_Registry* reg = check_registry(L, 1);
+    Uint32 e = check_entity(L, reg, 2);
+    position_component value = { (float)luaL_checknumber(L, 3), (float)luaL_checknumber(L, 4) };
+    *(position_component*)set_add(L, reg, COMPONENT_POSITION, e) = value;
+    return 0;
+}
+
+// sdl.entity_get_position(registry, entity) -> x, y (nil if absent)
+static int l_sdl_entity_get_position(lua_State* L) {
+    lua_SDL_Registry* reg = check_registry(L, 1);
+    Uint32 e = check_entity(L, reg, 2);
+    position_component* p = (position_component*)set_get(&reg->sets[0], e);
+    if (!p) {
+        lua_pushnil(L);
+        return 1;
+    }
+    lua_pushnumber(L, p->x);
+    lua_pushnumber(L, p->y);
+    return 2;
+}
+
+// sdl.entity_set_velocity(registry, entity, vx, vy)
+static int l_sdl_entity_set_velocity(lua_State* L) {
+    lua_SDL_Registry* reg = check_registry(L, 1);
+    Uint32 e = check_entity(L, reg, 2);
+    velocity_component value = { (float)luaL_checknumber(L, 3), (float)luaL_checknumber(L, 4) };
+    *(velocity_component*)set_add(L, reg, COMPONENT_VELOCITY, e) = value;
+    return 0;
+}
+
+// sdl.entity_get_velocity(registry, entity) -> vx, vy (nil if absent)
+static int l_sdl_entity_get_velocity(lua_State* L) {
+    lua_SDL_Registry* reg = check_registry(L, 1);
+    Uint32 e = check_entity(L, reg, 2);
+    velocity_component* v = (velocity_component*)set_get(&reg->sets[1], e);
+    if (!v) {
+        lua_pushnil(L);
+        return 1;
+    }
+    lua_pushnumber(L, v->vx);
+    lua_pushnumber(L, v->vy);
+    return 2;
+}
+
+// sdl.entity_set_color(registry, entity, r, g, b, [a]) with 0-255 values
+static int l_sdl_entity_set_color(lua_State* L) {
+    lua_SDL_Registry* reg = check_registry(L, 1);
+    Uint32 e = check_entity(L, reg, 2);
+    SDL_FColor value;
+    value.r = (float)luaL_checknumber(L, 3) / 255.0f;
+    value.g = (float)luaL_checknumber(L, 4) / 255.0f;
+    value.b = (float)luaL_checknumber(L, 5) / 255.0f;
+    value.a = (float)luaL_optnumber(L, 6, 255.0) / 255.0f;
+    *(SDL_FColor*)set_add(L, reg, COMPONENT_COLOR, e) = value;
+    return 0;
+}
+
+// Find or add the slot of a sprite texture (slots are 1-based).
+static int texture_slot(lua_State* L, lua_SDL_Registry* reg, int reg_idx, int tex_idx) {
+    SDL_Texture* texture = lua_check_SDL_Texture(L, tex_idx)->texture;
+    for (int i = 0; i < reg->texture_count; i++) {
+        if (reg->textures[i] == texture) {
+            return i + 1;
+        }
+    }
+    SDL_Texture** textures = (SDL_Texture**)realloc(reg->textures, (reg->texture_count + 1) * sizeof(SDL_Texture*));
+    if (!textures) {
+        luaL_error(L, "Failed to allocate texture list");
+    }
+    reg->textures = textures;
+    reg->textures[reg->texture_count++] = texture;
+
+    lua_getuservalue(L, reg_idx);
+    lua_pushvalue(L, tex_idx);
+    lua_rawseti(L, -2, reg->texture_count);
+    lua_pop(L, 1);
+    return reg->texture_count;
+}
+
+// Draw the entity as a w x h quad at its position (top-left):
+// sdl.entity_set_sprite(registry, entity, w, h, [texture, [sx, sy, sw, sh]])
+// The source rect is in texture pixels and defaults to the whole texture.
+static int l_sdl_entity_set_sprite(lua_State* L) {
+    lua_SDL_Registry* reg = check_registry(L, 1);
+    Uint32 e = check_entity(L, reg, 2);
+    float w = (float)luaL_checknumber(L, 3);
+    float h = (float)luaL_checknumber(L, 4);
+
+    sprite_component sprite = { w, h, 0, 0.0f, 0.0f, 1.0f, 1.0f };
+    if (!lua_isnoneornil(L, 5)) {
+        sprite.texture = texture_slot(L, reg, 1, 5);
+        if (!lua_isnoneornil(L, 6)) {
+            float tw, th;
+            if (!SDL_GetTextureSize(reg->textures[sprite.texture - 1], &tw, &th)) {
+                luaL_error(L, "Failed to get texture size: %s", SDL_GetError());
+            }
+            float sx = (float)luaL_checknumber(L, 6), sy = (float)luaL_checknumber(L, 7);
+            float sw = (float)luaL_checknumber(L, 8), sh = (float)luaL_checknumber(L, 9);
+            sprite.u0 = sx / tw;
+            sprite.v0 = sy / th;
+            sprite.u1 = (sx + sw) / tw;
+            sprite.v1 = (sy + sh) / th;
+        }
+    }
+    *(sprite_component*)set_add(L, reg, COMPONENT_SPRITE, e) = sprite;
+    return 0;
+}
+
+// Remove one component: sdl.entity_remove(registry, entity, sdl.COMPONENT_*)
+static int l_sdl_entity_remove(lua_State* L) {
+    lua_SDL_Registry* reg = check_registry(L, 1);
+    Uint32 e = check_entity(L, reg, 2);
+    lua_Integer component = luaL_checkinteger(L, 3);
+    if (component != COMPONENT_POSITION && component != COMPONENT_VELOCITY &&
+        component != COMPONENT_COLOR && component != COMPONENT_SPRITE) {
+        luaL_error(L, "Unknown component %d", (int)component);
+    }
+    set_remove(reg, (Uint8)component, e);
+    return 0;
+}
+
+// sdl.entity_has(registry, entity, mask) -> true if every component in mask is present
+static int l_sdl_entity_has(lua_State* L) {
+    lua_SDL_Registry* reg = check_registry(L, 1);
+    Uint32 e = check_entity(L, reg, 2);
+    Uint8 mask = (Uint8)(luaL_checkinteger(L, 3) & COMPONENT_ALL);
+    lua_pushboolean(L, (reg->mask[e] & mask) == mask);
+    return 1;
+}
+
+// Query iterator; upvalues: registry, mask, set being walked, last dense position.
+// It walks the smallest set in the mask from the end, so destroying the
+// current entity inside the loop is safe.
+static int registry_query_next(lua_State* L) {
+    lua_SDL_Registry* reg = check_registry(L, lua_upvalueindex(1));
+    Uint8 mask = (Uint8)lua_tointeger(L, lua_upvalueindex(2));
+    int set = (int)lua_tointeger(L, lua_upvalueindex(3));
+    int pos = (int)lua_tointeger(L, lua_upvalueindex(4));
+
+    sparse_set* s = &reg->sets[set];
+    while (--pos >= 0) {
+        if (pos >= s->count) {
+            continue; // shrank while iterating
+        }
+        Uint32 e = s->entity[pos];
+        if ((reg->mask[e] & mask) == mask) {
+            lua_pushinteger(L, pos);
+            lua_replace(L, lua_upvalueindex(4));
+            lua_pushinteger(L, make_handle(reg->generation[e], e));
+            return 1;
+        }
+    }
+    lua_pushinteger(L, 0);
+    lua_replace(L, lua_upvalueindex(4));
+    return 0;
+}
+
+// Iterate entities having every component in mask:
+// for e in sdl.registry_query(registry, sdl.COMPONENT_POSITION | sdl.COMPONENT_VELOCITY) do ... end
+static int l_sdl_registry_query(lua_State* L) {
+    lua_SDL_Registry* reg = check_registry(L, 1);
+    Uint8 mask = (Uint8)(luaL_checkinteger(L, 2) & COMPONENT_ALL);
+    if (mask == 0) {
+        luaL_error(L, "Query mask needs at least one component");
+    }
+
+    int smallest = -1;
+    for (int i = 0; i < COMPONENT_TYPES; i++) {
+        if ((mask & (1 << i)) && (smallest < 0 || reg->sets[i].count < reg->sets[smallest].count)) {
+            smallest = i;
+        }
+    }
+
+    lua_pushvalue(L, 1);
+    lua_pushinteger(L, mask);
+    lua_pushinteger(L, smallest);
+    lua_pushinteger(L, reg->sets[smallest].count);
+    lua_pushcclosure(L, registry_query_next, 4);
+    return 1;
+}
+
+// Move every entity with position and velocity: sdl.registry_integrate(registry, dt)
+static int l_sdl_registry_integrate(lua_State* L) {
+    lua_SDL_Registry* reg = check_registry(L, 1);
+    float dt = (float)luaL_checknumber(L, 2);
+
+    const sparse_set* vel = &reg->sets[1];
+    const sparse_set* pos = &reg->sets[0];
+    const velocity_component* v = (const velocity_component*)vel->data;
+    position_component* p = (position_component*)pos->data;
+    for (int i = 0; i < vel->count; i++) {
+        int d = pos->sparse[vel->entity[i]];
+        if (d >= 0) {
+            p[d].x += v[i].vx * dt;
+            p[d].y += v[i].vy * dt;
+        }
+    }
+    return 0;
+}
+
+// Bucket the sprite set's dense positions by texture slot (counting sort) into
+// reg->draw_order; bucket[slot] .. bucket[slot + 1] is the range of each slot.
+static void bucket_sprites(lua_State* L, lua_SDL_Registry* reg) {
+    const sparse_set* spr = &reg->sets[3];
+    const sprite_component* sprites = (const sprite_component*)spr->data;
+    int buckets = reg->texture_count + 1;
+
+    if (spr->count > reg->draw_capacity) {
+        int* order = (int*)realloc(reg->draw_order, spr->count * sizeof(int));
+        if (!order) {
+            luaL_error(L, "Failed to allocate memory for registry drawing");
+        }
+        reg->draw_order = order;
+        reg->draw_capacity = spr->count;
+    }
+    if (buckets + 1 > reg->bucket_capacity) {
+        int* bucket = (int*)realloc(reg->bucket, (buckets + 1) * sizeof(int));
+        if (!bucket) {
+            luaL_error(L, "Failed to allocate memory for registry drawing");
+        }
+        reg->bucket = bucket;
+        reg->bucket_capacity = buckets + 1;
+    }
+
+    memset(reg->bucket, 0, (buckets + 1) * sizeof(int));
+    for (int i = 0; i < spr->count; i++) {
+        reg->bucket[sprites[i].texture + 1]++;
+    }
+    for (int b = 0; b < buckets; b++) {
+        reg->bucket[b + 1] += reg->bucket[b];
+    }
+    // bucket[slot] is now the start of each slot; it is advanced while filling
+    for (int i = 0; i < spr->count; i++) {
+        reg->draw_order[reg->bucket[sprites[i].texture]++] = i;
+    }
+    // Filling moved every start to the next slot's start: shift back
+    for (int b = buckets; b > 0; b--) {
+        reg->bucket[b] = reg->bucket[b - 1];
+    }
+    reg->bucket[0] = 0;
+}
+
+// Draw every entity with position and sprite through the renderer batch,
+// tinted by its color component: sdl.render_registry(renderer, registry) -> drawn
+// Sprites are bucketed by texture once so the batch is not flushed at every
+// switch; draw order within a texture is storage order.
+static int l_sdl_render_registry(lua_State* L) {
+    lua_SDL_Renderer* ud = lua_check_SDL_Renderer(L, 1);
+    lua_SDL_Registry* reg = check_registry(L, 2);
+
+    if (!ud->renderer) {
+        luaL_error(L, "No renderer available");
+    }
+
+    sparse_set* spr = &reg->sets[3];
+    sparse_set* pos = &reg->sets[0];
+    sparse_set* col = &reg->sets[2];
+    const sprite_component* sprites = (const sprite_component*)spr->data;
+    const SDL_FColor white = { 1.0f, 1.0f, 1.0f, 1.0f };
+    int drawn = 0;
+
+    bucket_sprites(L, reg);
+    for (int slot = 0; slot <= reg->texture_count; slot++) {
+        SDL_Texture* texture = slot ? reg->textures[slot - 1] : NULL;
+        for (int k = reg->bucket[slot]; k < reg->bucket[slot + 1]; k++) {
+            int i = reg->draw_order[k];
+            const sprite_component* s = &sprites[i];
+            Uint32 e = spr->entity[i];
+            const position_component* p = (const position_component*)set_get(pos, e);
+            if (!p) {
+                continue;
+            }
+            const SDL_FColor* c = (const SDL_FColor*)set_get(col, e);
+
+            int* indices;
+            int base;
+            SDL_Vertex* v = sdl_batch_alloc(L, ud, texture, 4, 6, &indices, &base);
+            float x0 = p->x, y0 = p->y, x1 = p->x + s->w, y1 = p->y + s->h;
+            v[0].position.x = x0; v[0].position.y = y0; v[0].tex_coord.x = s->u0; v[0].tex_coord.y = s->v0;
+            v[1].position.x = x1; v[1].position.y = y0; v[1].tex_coord.x = s->u1; v[1].tex_coord.y = s->v0;
+            v[2].position.x = x1; v[2].position.y = y1; v[2].tex_coord.x = s->u1; v[2].tex_coord.y = s->v1;
+            v[3].position.x = x0; v[3].position.y = y1; v[3].tex_coord.x = s->u0; v[3].tex_coord.y = s->v1;
+            v[0].color = v[1].color = v[2].color = v[3].color = c ? *c : white;
+            indices[0] = base;     indices[1] = base + 1; indices[2] = base + 2;
+            indices[3] = base;     indices[4] = base + 2; indices[5] = base + 3;
+            drawn++;
+        }
+    }
+    lua_pushinteger(L, drawn);
+    return 1;
+}
+
+static const struct luaL_Reg registry_lib[] = {
+    {"create_registry", l_sdl_create_registry},
+    {"create_entity", l_sdl_create_entity},
+    {"destroy_entity", l_sdl_destroy_entity},
+    {"entity_valid", l_sdl_entity_valid},
+    {"entity_count", l_sdl_entity_count},
+    {"entity_set_position", l_sdl_entity_set_position},
+    {"entity_get_position", l_sdl_entity_get_position},
+    {"entity_set_velocity", l_sdl_entity_set_velocity},
+    {"entity_get_velocity", l_sdl_entity_get_velocity},
+    {"entity_set_color", l_sdl_entity_set_color},
+    {"entity_set_sprite", l_sdl_entity_set_sprite},
+    {"entity_remove", l_sdl_entity_remove},
+    {"entity_has", l_sdl_entity_has},
+    {"registry_query", l_sdl_registry_query},
+    {"registry_integrate", l_sdl_registry_integrate},
+    {"render_registry", l_sdl_render_registry},
+    {NULL, NULL}
+};
+
+// Create the registry metatable, add the entity functions and COMPONENT_* masks.
+void sdl_registry_register(lua_State* L) {
+    luaL_newmetatable(L, REGISTRY_MT);
+    lua_pushcfunction(L, registry_gc);
+    lua_setfield(L, -2, "__gc");
+    lua_pop(L, 1);
+
+    luaL_setfuncs(L, registry_lib, 0);
+
+    lua_pushinteger(L, COMPONENT_POSITION);
+    lua_setfield(L, -2, "COMPONENT_POSITION");
+    lua_pushinteger(L, COMPONENT_VELOCITY);
+    lua_setfield(L, -2, "COMPONENT_VELOCITY");
+    lua_pushinteger(L, COMPONENT_COLOR);
+    lua_setfield(L, -2, "COMPONENT_COLOR");
+    lua_pushinteger(L, COMPONENT_SPRITE);
+    lua_setfield(L, -2, "COMPONENT_SPRITE");
+}
@@ -0,0 +1,324 @@
+// sdl_reload.c
+// Hot reload of Lua scripts in the live lua_State. Modules loaded through
+// require are found by a package searcher installed ahead of the stock Lua
+// file searcher, which remembers each module's file and modification time.
+// While watching, the event pumps poll those times: a changed module is run
+// again and its new fields are copied into the table already stored in
+// package.loaded, so code holding the old table sees the new functions. A
+// changed main script unwinds the running script with an error; the host sees
+// sdl_reload_restart_requested() and runs it again in the same state, so
+// windows, renderers and textures kept in globals stay alive.
+//
+// Files are loaded from a precompiled "<name>.luac" next to "<name>.lua" when
+// one exists and is not older than the source.
+#include "module_sdl.h"
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct {
+    char* name; // module name, NULL for the main script
+    char* path;
+    SDL_Time mtime;
+} watched_file;
+
+static watched_file* watched = NULL;
+static int watched_count = 0, watched_capacity = 0;
+static watched_file main_script = { NULL, NULL, 0 };
+static bool watching = false;
+static Uint64 check_interval_ms = 250;
+static Uint64 last_check_ms = 0;
+static bool restart_requested = false;
+
+// Modification time of path, 0 if it cannot be read (missing, or mid-save).
+static SDL_Time file_mtime(const char* path) {
+    SDL_PathInfo info;
+    if (!SDL_GetPathInfo(path, &info) || info.type != SDL_PATHTYPE_FILE) {
+        return 0;
+    }
+    return info.modify_time;
+}
+
+// Load a Lua file like luaL_loadfile, preferring an up to date bytecode cache.
+int sdl_reload_loadfile(lua_State* L, const char* path) {
+    size_t len = strlen(path);
+    if (len > 4 && strcmp(path + len - 4, ".lua") == 0) {
+        char* cache = (char*)malloc(len + 2);
+        if (cache) {
+            memcpy(cache, path, len);
+            cache[len] = 'c';
+            cache[len + 1] = '\0';
+            SDL_Time cache_mtime = file_mtime(cache);
+            if (cache_mtime != 0 && cache_mtime >= file_mtime(path)) {
+                if (luaL_loadfilex(L, cache, "b") == LUA_OK) {
+                    free(cache);
+                    return LUA_OK;
+                }
+                lua_pop(L, 1); // unusable cache (other Lua version): fall back to source
+            }
+            free(cache);
+        }
+    }
+    return luaL_loadfilex(L, path, "t");
+}
+
+static char* copy_string(const char* s) {
+    size_t len = strlen(s) + 1;
+    char* copy = (char*)malloc(len);
+    if (copy) {
+        memcpy(copy, s, len);
+    }
+    return copy;
+}
+
+static void track_module(const char* name, const char* path) {
+    watched_file* w = NULL;
+    for (int i = 0; i < watched_count; i++) {
+        if (strcmp(watched[i].name, name) == 0) {
+            w = &watched[i];
+            break;
+        }
+    }
+    if (!w) {
+        if (watched_count == watched_capacity) {
+            int capacity = watched_capacity > 0 ? watched_capacity * 2 : 16;
+            watched_file* files = (watched_file*)realloc(watched, capacity * sizeof(watched_file));
+            if (!files) {
+                return; // module still loads, it just is not watched
+            }
+            watched = files;
+            watched_capacity = capacity;
+        }
+        char* name_copy = copy_string(name);
+        if (!name_copy) {
+            return;
+        }
+        w = &watched[watched_count++];
+        w->name = name_copy;
+        w->path = NULL;
+    }
+    char* path_copy = copy_string(path);
+    if (path_copy) {
+        free(w->path);
+        w->path = path_copy;
+    }
+    w->mtime = file_mtime(path);
+}
+
+// package.searchers entry: searcher(name) -> loader, path | message
+static int reload_searcher(lua_State* L) {
+    const char* name = luaL_checkstring(L, 1);
+    lua_getfield(L, lua_upvalueindex(1), "searchpath");
+    lua_pushstring(L, name);
+    lua_getfield(L, lua_upvalueindex(1), "path");
+    if (!lua_isfunction(L, -3) || !lua_isstring(L, -1)) {
+        lua_pushliteral(L, "package.path or package.searchpath missing");
+        return 1;
+    }
+    lua_call(L, 2, 2);
+    if (lua_isnil(L, -2)) {
+        return 1; // searchpath's message listing the files tried
+    }
+    const char* path = lua_tostring(L, -2);
+    if (sdl_reload_loadfile(L, path) != LUA_OK) {
+        return luaL_error(L, "error loading module '%s' from file '%s':\n\t%s", name, path, lua_tostring(L, -1));
+    }
+    track_module(name, path);
+    lua_pushstring(L, path);
+    return 2;
+}
+
+// Run tracked module i again. On failure the error message is left on the stack.
+// The chunk may require modules not seen before, which can move the watched
+// array, so its name is kept on the stack instead of a pointer into it.
+static bool reload_module(lua_State* L, int i) {
+    lua_pushstring(L, watched[i].name);
+    int name = lua_gettop(L);
+    if (sdl_reload_loadfile(L, watched[i].path) != LUA_OK) {
+        lua_remove(L, name);
+        return false;
+    }
+    lua_pushvalue(L, name);
+    lua_pushstring(L, watched[i].path);
+    if (lua_pcall(L, 2, 1, 0) != LUA_OK) {
+        lua_remove(L, name);
+        return false;
+    }
+
+    lua_getfield(L, LUA_REGISTRYINDEX, LUA_LOADED_TABLE);
+    lua_pushvalue(L, name);
+    lua_gettable(L, -2);
+    if (lua_istable(L, -1) && lua_istable(L, -3) && !lua_rawequal(L, -1, -3)) {
+        // Patch the old table in place; fields the new version dropped are kept
+        lua_pushnil(L);
+        while (lua_next(L, -4) != 0) {
+            lua_pushvalue(L, -2);
+            lua_insert(L, -2);
+            lua_rawset(L, -4);
+        }
+    } else if (!lua_isnil(L, -3)) {
+        lua_pushvalue(L, name);
+        lua_pushvalue(L, -4);
+        lua_settable(L, -4);
+    }
+    lua_pop(L, 4); // name, result, package.loaded, old value
+    return true;
+}
+
+// Reload every changed module and flag a changed main script. Returns the
+// number of modules reloaded; failures are logged and the old module is kept.
+static int check_files(lua_State* L) {
+    int reloaded = 0;
+    for (int i = 0; i < watched_count; i++) {
+        SDL_Time mtime = file_mtime(watched[i].path);
+        if (mtime == 0 || mtime == watched[i].mtime) {
+            continue;
+        }
+        watched[i].mtime = mtime; // also on failure, so a broken file is reported once per save
+        // watched may have moved during the reload: index it again
+        if (reload_module(L, i)) {
+            SDL_Log("Reloaded module '%s'", watched[i].name);
+            reloaded++;
+        } else {
+            SDL_Log("Reload of module '%s' failed: %s", watched[i].name, lua_tostring(L, -1));
+            lua_pop(L, 1);
+        }
+    }
+    if (main_script.path) {
+        SDL_Time mtime = file_mtime(main_script.path);
+        if (mtime != 0 && mtime != main_script.mtime) {
+            main_script.mtime = mtime;
+            restart_requested = true;
+        }
+    }
+    return reloaded;
+}
+
+// Unwind the running script so the host runs the changed main script again.
+static int restart_script(lua_State* L) {
+    lua_pushliteral(L, "script changed, restarting");
+    return lua_error(L);
+}
+
+// Called from the event pumps: check the watched files once per interval.
+void sdl_reload_poll(lua_State* L) {
+    if (!watching) {
+        return;
+    }
+    Uint64 now = SDL_GetTicks();
+    if (now - last_check_ms < check_interval_ms) {
+        return;
+    }
+    last_check_ms = now;
+    check_files(L);
+    if (restart_requested) {
+        restart_script(L);
+    }
+}
+
+void sdl_reload_watch(bool enabled) {
+    watching = enabled;
+}
+
+// Remember the host's main script so a change to it restarts the script.
+void sdl_reload_set_main(const char* path) {
+    free(main_script.path);
+    main_script.path = copy_string(path);
+    main_script.mtime = file_mtime(path);
+}
+
+// True once after a changed main script unwound the running script.
+bool sdl_reload_restart_requested(void) {
+    bool requested = restart_requested;
+    restart_requested = false;
+    return requested;
+}
+
+// Block until a watched file changes (after the script failed). Keeps the
+// event queue drained so windows stay responsive; false if quit was requested.
+bool sdl_reload_wait(lua_State* L) {
+    for (;;) {
+        SDL_Event e;
+        while (SDL_PollEvent(&e)) {
+            if (e.type == SDL_EVENT_QUIT) {
+                return false;
+            }
+        }
+        if (check_files(L) > 0 || restart_requested) {
+            restart_requested = false;
+            return true;
+        }
+        SDL_Delay((Uint32)check_interval_ms);
+    }
+}
+
+// Poll script files for changes from poll_events/update_input:
+// sdl.watch_scripts(enabled, [interval_ms])
+static int l_sdl_watch_scripts(lua_State* L) {
+    watching = lua_toboolean(L, 1);
+    lua_Integer interval = luaL_optinteger(L, 2, (lua_Integer)check_interval_ms);
+    if (interval < 0) {
+        luaL_error(L, "Interval must not be negative");
+    }
+    check_interval_ms = (Uint64)interval;
+    return 0;
+}
+
+// Check the watched files now: sdl.check_reload() -> modules reloaded
+// A changed main script unwinds the running script so the host restarts it.
+static int l_sdl_check_reload(lua_State* L) {
+    int reloaded = check_files(L);
+    if (restart_requested) {
+        return restart_script(L);
+    }
+    lua_pushinteger(L, reloaded);
+    return 1;
+}
+
+// Run a required module again even if unchanged: sdl.reload_module(name) -> true | false, message
+static int l_sdl_reload_module(lua_State* L) {
+    const char* name = luaL_checkstring(L, 1);
+    for (int i = 0; i < watched_count; i++) {
+        if (strcmp(watched[i].name, name) == 0) {
+            watched[i].mtime = file_mtime(watched[i].path);
+            if (!reload_module(L, i)) {
+                lua_pushboolean(L, false);
+                lua_insert(L, -2);
+                return 2;
+            }
+            lua_pushboolean(L, true);
+            return 1;
+        }
+    }
+    lua_pushboolean(L, false);
+    lua_pushfstring(L, "module '%s' was not loaded from a Lua file", name);
+    return 2;
+}
+
+static const struct luaL_Reg reload_lib[] = {
+    {"watch_scripts", l_sdl_watch_scripts},
+    {"check_reload", l_sdl_check_reload},
+    {"reload_module", l_sdl_reload_module},
+    {NULL, NULL}
+};
+
+// Add the reload functions to the sdl module table and install the tracking
+// searcher as package.searchers[2], ahead of the stock Lua file searcher.
+void sdl_reload_register(lua_State* L) {
+    luaL_setfuncs(L, reload_lib, 0);
+
+    lua_getglobal(L, "package");
+    if (lua_istable(L, -1)) {
+        lua_getfield(L, -1, "searchers");
+        if (lua_istable(L, -1)) {
+            for (lua_Integer i = (lua_Integer)lua_rawlen(L, -1); i >= 2; i--) {
+                lua_rawgeti(L, -1, i);
+                lua_rawseti(L, -2, i + 1);
+            }
+            lua_pushvalue(L, -2);
+            lua_pushcclosure(L, reload_searcher, 1);
+            lua_rawseti(L, -2, 2);
+        }
+        lua_pop(L, 1);
+    }
+    lua_pop(L, 1);
+}
@@ -0,0 +1,339 @@
+// sdl_replay.c
+// Input recording and deterministic replay. Recording writes the input events
+// seen by poll_events/update_input to a compact binary file, tagged with the
+// number of the event pump they arrived in. Replay pushes them back through
+// SDL_PushEvent at the same pump and drops live input, so a script that makes
+// the same calls sees the same events. A fixed clock makes get_ticks advance by
+// a constant step per presented frame.
+//
+// File layout (little endian):
+//   "SDLREPL1"  u32 sizeof(SDL_Event)  u64 fixed_dt_ns
+//   records:    u32 pump  u16 size  size bytes of the SDL_Event
+#include "module_sdl.h"
+#include <string.h>
+
+static const char REPLAY_MAGIC[8] = { 'S', 'D', 'L', 'R', 'E', 'P', 'L', '1' };
+
+static SDL_IOStream* record_io = NULL;
+static SDL_IOStream* replay_io = NULL; // open until the last record was read
+static bool replaying = false;          // replay mode, kept after end of file until stopped
+static Uint32 pump_count = 0;    // event pumps so far (poll_events / update_input)
+static Uint32 present_count = 0; // presented frames, drives the fixed clock
+static Uint64 fixed_dt_ns = 0;
+
+// Host --frames limit and real frame times between presents
+static Uint32 frame_limit = 0;
+static bool frame_limit_hit = false;
+static Uint64 last_present_ns = 0;
+static Uint64 frame_time_sum_ns = 0, frame_time_min_ns = 0, frame_time_max_ns = 0;
+static Uint32 frame_time_count = 0;
+
+// Next record read from the replay file, not yet pushed
+static bool replay_pending = false;
+static Uint32 replay_pending_pump = 0;
+static SDL_Event replay_pending_event;
+
+// Stored in common.reserved of pushed events to tell them from live input
+#define REPLAY_MARK 0x52504C59u
+
+// Bytes of the SDL_Event union worth storing for a type, 0 = not recorded.
+// Events carrying pointers (text input, drops, user events) are never recorded.
+static int recorded_size(Uint32 type) {
+    switch (type) {
+        case SDL_EVENT_QUIT:
+            return sizeof(SDL_QuitEvent);
+        case SDL_EVENT_KEY_DOWN:
+        case SDL_EVENT_KEY_UP:
+            return sizeof(SDL_KeyboardEvent);
+        case SDL_EVENT_MOUSE_MOTION:
+            return sizeof(SDL_MouseMotionEvent);
+        case SDL_EVENT_MOUSE_BUTTON_DOWN:
+        case SDL_EVENT_MOUSE_BUTTON_UP:
+            return sizeof(SDL_MouseButtonEvent);
+        case SDL_EVENT_MOUSE_WHEEL:
+            return sizeof(SDL_MouseWheelEvent);
+        default:
+            if (type >= SDL_EVENT_WINDOW_FIRST && type <= SDL_EVENT_WINDOW_LAST) {
+                return sizeof(SDL_WindowEvent);
+            }
+            return 0;
+    }
+}
+
+// True from replay start until sdl_replay_close, also after the file ran out,
+// so live input stays ignored and the run remains deterministic.
+bool sdl_replay_active(void) {
+    return replaying;
+}
+
+void sdl_replay_close(void) {
+    if (record_io) {
+        SDL_CloseIO(record_io);
+        record_io = NULL;
+    }
+    if (replay_io) {
+        SDL_CloseIO(replay_io);
+        replay_io = NULL;
+    }
+    replay_pending = false;
+    replaying = false;
+}
+
+bool sdl_replay_record(const char* path) {
+    sdl_replay_close();
+    record_io = SDL_IOFromFile(path, "wb");
+    if (!record_io) {
+        return false;
+    }
+    bool ok = SDL_WriteIO(record_io, REPLAY_MAGIC, sizeof(REPLAY_MAGIC)) == sizeof(REPLAY_MAGIC) &&
+              SDL_WriteU32LE(record_io, (Uint32)sizeof(SDL_Event)) &&
+              SDL_WriteU64LE(record_io, fixed_dt_ns);
+    if (!ok) {
+        sdl_replay_close();
+    }
+    pump_count = 0;
+    present_count = 0;
+    return ok;
+}
+
+// Read the next record into replay_pending; closes the file (but stays in
+// replay mode) at end of file.
+static void replay_read_next(void) {
+    Uint32 pump;
+    Uint16 size;
+    replay_pending = false;
+    if (!SDL_ReadU32LE(replay_io, &pump) || !SDL_ReadU16LE(replay_io, &size) || size > sizeof(SDL_Event)) {
+        SDL_CloseIO(replay_io);
+        replay_io = NULL;
+        return;
+    }
+    memset(&replay_pending_event, 0, sizeof(SDL_Event));
+    if (SDL_ReadIO(replay_io, &replay_pending_event, size) != size) {
+        SDL_CloseIO(replay_io);
+        replay_io = NULL;
+        return;
+    }
+    replay_pending_pump = pump;
+    replay_pending = true;
+}
+
+bool sdl_replay_play(const char* path) {
+    sdl_replay_close();
+    replay_io = SDL_IOFromFile(path, "rb");
+    if (!replay_io) {
+        return false;
+    }
+
+    char magic[sizeof(REPLAY_MAGIC)];
+    Uint32 event_size;
+    Uint64 dt_ns;
+    if (SDL_ReadIO(replay_io, magic, sizeof(magic)) != sizeof(magic) ||
+        memcmp(magic, REPLAY_MAGIC, sizeof(magic)) != 0 ||
+        !SDL_ReadU32LE(replay_io, &event_size) || event_size != sizeof(SDL_Event) ||
+        !SDL_ReadU64LE(replay_io, &dt_ns)) {
+        sdl_replay_close();
+        return SDL_SetError("Not a replay file (or recorded with another SDL build): %s", path);
+    }
+
+    // The recording's clock comes along unless one was set explicitly
+    if (fixed_dt_ns == 0) {
+        fixed_dt_ns = dt_ns;
+    }
+    pump_count = 0;
+    present_count = 0;
+    replaying = true;
+    replay_read_next();
+    return true;
+}
+
+void sdl_replay_set_fixed_clock(Uint64 dt_ns) {
+    fixed_dt_ns = dt_ns;
+}
+
+// Start of an event pump (poll_events / update_input): push the replayed
+// events that belong to it. Returns false if pushing failed.
+bool sdl_replay_begin_pump(void) {
+    pump_count++;
+    while (replay_io && replay_pending && replay_pending_pump <= pump_count) {
+        SDL_Event e = replay_pending_event;
+        e.common.reserved = REPLAY_MARK;
+        e.common.timestamp = 0; // SDL stamps it on push
+        sdl_input_apply_event(&e);
+        if (!SDL_PushEvent(&e)) {
+            return false;
+        }
+        replay_read_next();
+    }
+    return true;
+}
+
+// Filter for events taken off the queue. Records them, and while replaying
+// drops live input so only the recorded stream reaches the script. Live quit
+// and window close requests still pass so a replaying window can be closed.
+bool sdl_replay_accept_event(SDL_Event* e) {
+    int size = recorded_size(e->type);
+    if (size == 0) {
+        return true;
+    }
+
+    if (e->common.reserved == REPLAY_MARK) {
+        e->common.reserved = 0;
+        return true;
+    }
+    if (replaying) {
+        return e->type == SDL_EVENT_QUIT || e->type == SDL_EVENT_WINDOW_CLOSE_REQUESTED;
+    }
+
+    if (record_io) {
+        SDL_Event copy;
+        memcpy(&copy, e, size);
+        copy.common.timestamp = 0; // keep recordings byte identical across runs
+        if (!SDL_WriteU32LE(record_io, pump_count) || !SDL_WriteU16LE(record_io, (Uint16)size) ||
+            SDL_WriteIO(record_io, &copy, size) != (size_t)size) {
+            SDL_Log("Replay recording failed, stopping: %s", SDL_GetError());
+            SDL_CloseIO(record_io);
+            record_io = NULL;
+        }
+    }
+    return true;
+}
+
+// True if the frame being presented is the last one of a --frames run.
+bool sdl_replay_last_frame(void) {
+    return frame_limit > 0 && present_count + 1 >= frame_limit;
+}
+
+// Called from render_present after SDL_RenderPresent.
+void sdl_replay_end_frame(void) {
+    present_count++;
+
+    Uint64 now = SDL_GetTicksNS();
+    if (last_present_ns > 0) {
+        Uint64 dt = now - last_present_ns;
+        if (frame_time_count == 0 || dt < frame_time_min_ns) frame_time_min_ns = dt;
+        if (dt > frame_time_max_ns) frame_time_max_ns = dt;
+        frame_time_sum_ns += dt;
+        frame_time_count++;
+    }
+    last_present_ns = now;
+}
+
+void sdl_replay_set_frame_limit(Uint32 frames) {
+    frame_limit = frames;
+}
+
+// Unwind the running script after the last frame; the host checks
+// sdl_replay_frame_limit_hit() to treat the error as a normal exit.
+int sdl_replay_stop_script(lua_State* L) {
+    frame_limit_hit = true;
+    lua_pushliteral(L, "frame limit reached");
+    return lua_error(L);
+}
+
+bool sdl_replay_frame_limit_hit(void) {
+    return frame_limit_hit;
+}
+
+// Presented frames and the real time in ms between consecutive presents.
+void sdl_replay_frame_stats(Uint32* count, double* avg_ms, double* min_ms, double* max_ms) {
+    *count = present_count;
+    *avg_ms = frame_time_count ? (double)frame_time_sum_ns / frame_time_count / SDL_NS_PER_MS : 0.0;
+    *min_ms = (double)frame_time_min_ns / SDL_NS_PER_MS;
+    *max_ms = (double)frame_time_max_ns / SDL_NS_PER_MS;
+}
+
+Uint64 sdl_replay_ticks_ns(void) {
+    if (fixed_dt_ns > 0) {
+        return (Uint64)present_count * fixed_dt_ns;
+    }
+    return SDL_GetTicksNS();
+}
+
+// Record input events to a file: sdl.record_events(path)
+static int l_sdl_record_events(lua_State* L) {
+    const char* path = luaL_checkstring(L, 1);
+    if (!sdl_replay_record(path)) {
+        luaL_error(L, "Failed to start recording '%s': %s", path, SDL_GetError());
+    }
+    return 0;
+}
+
+// Replay a recording (live input is ignored meanwhile): sdl.replay_events(path)
+static int l_sdl_replay_events(lua_State* L) {
+    const char* path = luaL_checkstring(L, 1);
+    if (!sdl_replay_play(path)) {
+        luaL_error(L, "Failed to start replay '%s': %s", path, SDL_GetError());
+    }
+    return 0;
+}
+
+// Stop recording or replaying: sdl.stop_replay()
+static int l_sdl_stop_replay(lua_State* L) {
+    sdl_replay_close();
+    return 0;
+}
+
+// Replay mode (stays on after the last event until stop_replay):
+// sdl.is_replaying() -> replaying, events_left
+static int l_sdl_is_replaying(lua_State* L) {
+    lua_pushboolean(L, sdl_replay_active());
+    lua_pushboolean(L, replay_pending);
+    return 2;
+}
+
+// Advance get_ticks by a fixed step per presented frame (0 = real time): sdl.set_fixed_clock(ms)
+static int l_sdl_set_fixed_clock(lua_State* L) {
+    lua_Number ms = luaL_checknumber(L, 1);
+    sdl_replay_set_fixed_clock(ms > 0 ? (Uint64)(ms * SDL_NS_PER_MS) : 0);
+    return 0;
+}
+
+// Milliseconds since init (or since the fixed clock started): sdl.get_ticks()
+static int l_sdl_get_ticks(lua_State* L) {
+    lua_pushnumber(L, (lua_Number)sdl_replay_ticks_ns() / SDL_NS_PER_MS);
+    return 1;
+}
+
+// Number of presented frames: sdl.get_frame()
+static int l_sdl_get_frame(lua_State* L) {
+    lua_pushinteger(L, present_count);
+    return 1;
+}
+
+// Real time between presents: sdl.get_frame_stats() -> count, avg_ms, min_ms, max_ms
+static int l_sdl_get_frame_stats(lua_State* L) {
+    Uint32 count;
+    double avg_ms, min_ms, max_ms;
+    sdl_replay_frame_stats(&count, &avg_ms, &min_ms, &max_ms);
+    lua_pushinteger(L, count);
+    lua_pushnumber(L, avg_ms);
+    lua_pushnumber(L, min_ms);
+    lua_pushnumber(L, max_ms);
+    return 4;
+}
+
+// Set an SDL hint, e.g. sdl.set_hint("SDL_VIDEO_DRIVER", "offscreen") before sdl.init
+static int l_sdl_set_hint(lua_State* L) {
+    const char* name = luaL_checkstring(L, 1);
+    const char* value = luaL_checkstring(L, 2);
+    lua_pushboolean(L, SDL_SetHint(name, value));
+    return 1;
+}
+
+static const struct luaL_Reg replay_lib[] = {
+    {"record_events", l_sdl_record_events},
+    {"replay_events", l_sdl_replay_events},
+    {"stop_replay", l_sdl_stop_replay},
+    {"is_replaying", l_sdl_is_replaying},
+    {"set_fixed_clock", l_sdl_set_fixed_clock},
+    {"get_ticks", l_sdl_get_ticks},
+    {"get_frame", l_sdl_get_frame},
+    {"get_frame_stats", l_sdl_get_frame_stats},
+    {"set_hint", l_sdl_set_hint},
+    {NULL, NULL}
+};
+
+// Add the replay/clock functions to the sdl module table on top of the stack.
+void sdl_replay_register(lua_State* L) {
+    luaL_setfuncs(L, replay_lib, 0);
+}
@@ -0,0 +1,341 @@
+// sdl_scene.c
+// Retained scene of simple drawables indexed by a spatial hash grid. Each
+// render queries the grid with the view bounds and only visible items are
+// written to the renderer batch.
+#include "module_sdl.h"
+#include <stdlib.h>
+#include <string.h>
+
+static const char* SCENE_MT = "sdl.scene";
+
+enum {
+    SCENE_RECT = 1,
+    SCENE_CIRCLE = 2 // circle inscribed in the item box
+};
+
+typedef struct {
+    SDL_FRect box;
+    SDL_Color color;
+    Uint8 kind; // 0 = free slot
+} scene_item;
+
+typedef struct {
+    sdl_grid grid;
+    scene_item* items;
+    Uint32* stamps; // last query that visited each item, for dedupe
+    int count, capacity;
+    int* free_ids;
+    int free_count, free_capacity;
+    int live;
+    Uint32 stamp;
+    int* visible; // scratch for query results
+    int visible_count, visible_capacity;
+} lua_SDL_Scene;
+
+static lua_SDL_Scene* check_scene(lua_State* L, int idx) {
+    lua_SDL_Scene* scene = (lua_SDL_Scene*)luaL_checkudata(L, idx, SCENE_MT);
+    if (!scene->grid.cell_size) {
+        luaL_error(L, "Invalid scene (already destroyed)");
+    }
+    return scene;
+}
+
+static int scene_gc(lua_State* L) {
+    lua_SDL_Scene* scene = (lua_SDL_Scene*)luaL_checkudata(L, 1, SCENE_MT);
+    sdl_grid_free(&scene->grid);
+    free(scene->items);
+    free(scene->stamps);
+    free(scene->free_ids);
+    free(scene->visible);
+    memset(scene, 0, sizeof(lua_SDL_Scene));
+    return 0;
+}
+
+// Lua ids are 1-based item slots.
+static int check_item(lua_State* L, lua_SDL_Scene* scene, int arg) {
+    lua_Integer id = luaL_checkinteger(L, arg);
+    if (id < 1 || id > scene->count || scene->items[id - 1].kind == 0) {
+        luaL_error(L, "Invalid scene item id %d", (int)id);
+    }
+    return (int)id - 1;
+}
+
+static void visit_visible(int id, void* ctx) {
+    lua_SDL_Scene* scene = (lua_SDL_Scene*)ctx;
+    if (scene->stamps[id] == scene->stamp) {
+        return;
+    }
+    scene->stamps[id] = scene->stamp;
+    if (scene->visible_count < scene->visible_capacity) {
+        scene->visible[scene->visible_count] = id;
+    }
+    scene->visible_count++; // counts past capacity so the caller can grow and retry
+}
+
+static int compare_ids(const void* a, const void* b) {
+    int x = *(const int*)a, y = *(const int*)b;
+    return (x > y) - (x < y);
+}
+
+// Collect ids of items whose box overlaps `box`, sorted by id (= insertion order).
+static void scene_query(lua_State* L, lua_SDL_Scene* scene, const SDL_FRect* box) {
+    for (;;) {
+        if (++scene->stamp == 0) {
+            // Stamp wrapped: clear so old marks cannot match
+            memset(scene->stamps, 0, scene->count * sizeof(Uint32));
+            scene->stamp = 1;
+        }
+        scene->visible_count = 0;
+        sdl_grid_query(&scene->grid, box, visit_visible, scene);
+        if (scene->visible_count <= scene->visible_capacity) {
+            break;
+        }
+        int capacity = scene->visible_count * 2;
+        int* visible = (int*)realloc(scene->visible, capacity * sizeof(int));
+        if (!visible) {
+            luaL_error(L, "Failed to allocate memory for scene query");
+        }
+        scene->visible = visible;
+        scene->visible_capacity = capacity;
+    }
+
+    // Grid cells are coarse: keep only true overlaps
+    int n = 0;
+    for (int i = 0; i < scene->visible_count; i++) {
+        const SDL_FRect* b = &scene->items[scene->visible[i]].box;
+        if (b->x <= box->x + box->w && b->x + b->w >= box->x && b->y <= box->y + box->h && b->y + b->h >= box->y) {
+            scene->visible[n++] = scene->visible[i];
+        }
+    }
+    scene->visible_count = n;
+    qsort(scene->visible, n, sizeof(int), compare_ids);
+}
+
+// Create a scene: sdl.create_scene([cell_size])
+static int l_sdl_create_scene(lua_State* L) {
+    float cell_size = (float)luaL_optnumber(L, 1, 256.0);
+    if (cell_size <= 0.0f) {
+        luaL_error(L, "Cell size must be positive");
+    }
+
+    lua_SDL_Scene* scene = (lua_SDL_Scene*)lua_newuserdata(L, sizeof(lua_SDL_Scene));
+    memset(scene, 0, sizeof(lua_SDL_Scene));
+    sdl_grid_init(&scene->grid, cell_size);
+    luaL_setmetatable(L, SCENE_MT);
+    return 1;
+}
+
+static SDL_Color check_color(lua_State* L, int arg) {
+    SDL_Color c;
+    int r = (int)luaL_checkinteger(L, arg);
+    int g = (int)luaL_checkinteger(L, arg + 1);
+    int b = (int)luaL_checkinteger(L, arg + 2);
+    int a = (int)luaL_optinteger(L, arg + 3, 255);
+    c.r = (Uint8)SDL_clamp(r, 0, 255);
+    c.g = (Uint8)SDL_clamp(g, 0, 255);
+    c.b = (Uint8)SDL_clamp(b, 0, 255);
+    c.a = (Uint8)SDL_clamp(a, 0, 255);
+    return c;
+}
+
+// Add an item: sdl.scene_add(scene, kind, x, y, w, h, r, g, b, [a]) -> id
+static int l_sdl_scene_add(lua_State* L) {
+    lua_SDL_Scene* scene = check_scene(L, 1);
+    int kind = (int)luaL_checkinteger(L, 2);
+    SDL_FRect box;
+    box.x = (float)luaL_checknumber(L, 3);
+    box.y = (float)luaL_checknumber(L, 4);
+    box.w = (float)luaL_checknumber(L, 5);
+    box.h = (float)luaL_checknumber(L, 6);
+    SDL_Color color = check_color(L, 7);
+
+    if (kind != SCENE_RECT && kind != SCENE_CIRCLE) {
+        luaL_error(L, "Unknown scene item kind %d", kind);
+    }
+    if (!sdl_grid_box_valid(&scene->grid, &box)) {
+        luaL_error(L, "Item box must be finite and cover at most 65536 grid cells");
+    }
+
+    // The id is only taken once the grid insert succeeded
+    int id;
+    if (scene->free_count > 0) {
+        id = scene->free_ids[scene->free_count - 1];
+    } else {
+        if (scene->count == scene->capacity) {
+            int capacity = scene->capacity > 0 ? scene->capacity * 2 : 1024;
+            scene_item* items = (scene_item*)realloc(scene->items, capacity * sizeof(scene_item));
+            if (!items) {
+                luaL_error(L, "Failed to allocate memory for scene items");
+            }
+            scene->items = items;
+            Uint32* stamps = (Uint32*)realloc(scene->stamps, capacity * sizeof(Uint32));
+            if (!stamps) {
+                luaL_error(L, "Failed to allocate memory for scene items");
+            }
+            scene->stamps = stamps;
+            scene->capacity = capacity;
+        }
+        id = scene->count;
+    }
+    if (!sdl_grid_insert(&scene->grid, id, &box)) {
+        luaL_error(L, "Failed to allocate memory for scene grid");
+    }
+    if (scene->free_count > 0) {
+        scene->free_count--;
+    } else {
+        scene->count++;
+    }
+
+    scene_item* item = &scene->items[id];
+    item->box = box;
+    item->color = color;
+    item->kind = (Uint8)kind;
+    scene->stamps[id] = 0;
+    scene->live++;
+
+    lua_pushinteger(L, id + 1);
+    return 1;
+}
+
+// Move or resize an item: sdl.scene_move(scene, id, x, y, [w], [h])
+static int l_sdl_scene_move(lua_State* L) {
+    lua_SDL_Scene* scene = check_scene(L, 1);
+    int id = check_item(L, scene, 2);
+    scene_item* item = &scene->items[id];
+
+    SDL_FRect box = item->box;
+    box.x = (float)luaL_checknumber(L, 3);
+    box.y = (float)luaL_checknumber(L, 4);
+    box.w = (float)luaL_optnumber(L, 5, box.w);
+    box.h = (float)luaL_optnumber(L, 6, box.h);
+    if (!sdl_grid_box_valid(&scene->grid, &box)) {
+        luaL_error(L, "Item box must be finite and cover at most 65536 grid cells");
+    }
+
+    if (!sdl_grid_move(&scene->grid, id, &item->box, &box)) {
+        luaL_error(L, "Failed to allocate memory for scene grid");
+    }
+    item->box = box;
+    return 0;
+}
+
+// Change an item color: sdl.scene_set_color(scene, id, r, g, b, [a])
+static int l_sdl_scene_set_color(lua_State* L) {
+    lua_SDL_Scene* scene = check_scene(L, 1);
+    int id = check_item(L, scene, 2);
+    scene->items[id].color = check_color(L, 3);
+    return 0;
+}
+
+// Remove an item (its id may be reused): sdl.scene_remove(scene, id)
+static int l_sdl_scene_remove(lua_State* L) {
+    lua_SDL_Scene* scene = check_scene(L, 1);
+    int id = check_item(L, scene, 2);
+
+    if (scene->free_count == scene->free_capacity) {
+        int capacity = scene->free_capacity > 0 ? scene->free_capacity * 2 : 256;
+        int* free_ids = (int*)realloc(scene->free_ids, capacity * sizeof(int));
+        if (!free_ids) {
+            luaL_error(L, "Failed to allocate memory for scene free list");
+        }
+        scene->free_ids = free_ids;
+        scene->free_capacity = capacity;
+    }
+
+    sdl_grid_remove(&scene->grid, id, &scene->items[id].box);
+    scene->items[id].kind = 0;
+    scene->free_ids[scene->free_count++] = id;
+    scene->live--;
+    return 0;
+}
+
+// Number of live items: sdl.scene_count(scene)
+static int l_sdl_scene_count(lua_State* L) {
+    lua_SDL_Scene* scene = check_scene(L, 1);
+    lua_pushinteger(L, scene->live);
+    return 1;
+}
+
+// Ids overlapping a rect: sdl.scene_query(scene, x, y, w, h, [out_table]) -> table
+static int l_sdl_scene_query(lua_State* L) {
+    lua_SDL_Scene* scene = check_scene(L, 1);
+    SDL_FRect box;
+    box.x = (float)luaL_checknumber(L, 2);
+    box.y = (float)luaL_checknumber(L, 3);
+    box.w = (float)luaL_checknumber(L, 4);
+    box.h = (float)luaL_checknumber(L, 5);
+
+    scene_query(L, scene, &box);
+
+    if (lua_istable(L, 6)) {
+        lua_pushvalue(L, 6); // reuse the caller's table, clearing the old tail
+        int old = (int)lua_rawlen(L, -1);
+        for (int i = old; i > scene->visible_count; i--) {
+            lua_pushnil(L);
+            lua_rawseti(L, -2, i);
+        }
+    } else {
+        lua_createtable(L, scene->visible_count, 0);
+    }
+    for (int i = 0; i < scene->visible_count; i++) {
+        lua_pushinteger(L, scene->visible[i] + 1);
+        lua_rawseti(L, -2, i + 1);
+    }
+    return 1;
+}
+
+// Draw the visible items: sdl.render_scene(renderer, scene) -> number drawn
+static int l_sdl_render_scene(lua_State* L) {
+    lua_SDL_Renderer* ud = lua_check_SDL_Renderer(L, 1);
+    lua_SDL_Scene* scene = check_scene(L, 2);
+
+    SDL_FRect view;
+    if (!sdl_view_bounds(ud, &view)) {
+        lua_pushinteger(L, 0);
+        return 1;
+    }
+    scene_query(L, scene, &view);
+
+    for (int i = 0; i < scene->visible_count; i++) {
+        const scene_item* item = &scene->items[scene->visible[i]];
+        SDL_FColor color = {
+            item->color.r / 255.0f, item->color.g / 255.0f, item->color.b / 255.0f, item->color.a / 255.0f
+        };
+        if (item->kind == SCENE_RECT) {
+            sdl_shape_fill_quad(L, ud, &item->box, color);
+        } else {
+            float r = (item->box.w < item->box.h ? item->box.w : item->box.h) * 0.5f;
+            sdl_shape_fill_circle(L, ud, item->box.x + item->box.w * 0.5f, item->box.y + item->box.h * 0.5f, r, color);
+        }
+    }
+
+    lua_pushinteger(L, scene->visible_count);
+    return 1;
+}
+
+static const struct luaL_Reg scene_lib[] = {
+    {"create_scene", l_sdl_create_scene},
+    {"scene_add", l_sdl_scene_add},
+    {"scene_move", l_sdl_scene_move},
+    {"scene_set_color", l_sdl_scene_set_color},
+    {"scene_remove", l_sdl_scene_remove},
+    {"scene_count", l_sdl_scene_count},
+    {"scene_query", l_sdl_scene_query},
+    {"render_scene", l_sdl_render_scene},
+    {NULL, NULL}
+};
+
+// Create the scene metatable and add the scene functions to the sdl module table.
+void sdl_scene_register(lua_State* L) {
+    luaL_newmetatable(L, SCENE_MT);
+    lua_pushcfunction(L, scene_gc);
+    lua_setfield(L, -2, "__gc");
+    lua_pop(L, 1);
+
+    luaL_setfuncs(L, scene_lib, 0);
+
+    lua_pushinteger(L, SCENE_RECT);
+    lua_setfield(L, -2, "SCENE_RECT");
+    lua_pushinteger(L, SCENE_CIRCLE);
+    lua_setfield(L, -2, "SCENE_CIRCLE");
+}
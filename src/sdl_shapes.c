@@ -0,0 +1,437 @@
+// sdl_shapes.c
+// Native tessellation for circles, arcs, rounded rects, polygons and thick lines.
+// Shapes are written into the renderer batch (sdl_batch.c) using the current
+// draw color, so many shapes end up in one SDL_RenderGeometry call. Segment
+// counts follow the on-screen radius, so zooming in keeps curves smooth.
+#include "module_sdl.h"
+
+#define SHAPE_PI 3.14159265358979f
+#define SHAPE_TOLERANCE 0.25f   // max distance (pixels) between the curve and its chords
+#define SHAPE_MAX_SEGMENTS 1024
+#define SHAPE_MITER_LIMIT 4.0f  // miter length limit, in half thicknesses
+
+static inline void set_vertex(SDL_Vertex* v, float x, float y, SDL_FColor color) {
+    v->position.x = x;
+    v->position.y = y;
+    v->color = color;
+    v->tex_coord.x = 0.0f;
+    v->tex_coord.y = 0.0f;
+}
+
+// Renderer argument whose SDL renderer has not been destroyed.
+static lua_SDL_Renderer* check_renderer(lua_State* L, int arg) {
+    lua_SDL_Renderer* ud = lua_check_SDL_Renderer(L, arg);
+    if (!ud->renderer) {
+        luaL_error(L, "No renderer available");
+    }
+    return ud;
+}
+
+// Sweeps past a full turn only draw over themselves; NaN becomes 0 (nothing drawn).
+static float clamp_sweep(float sweep) {
+    if (sweep > 2.0f * SHAPE_PI) return 2.0f * SHAPE_PI;
+    if (sweep < -2.0f * SHAPE_PI) return -2.0f * SHAPE_PI;
+    return sweep == sweep ? sweep : 0.0f;
+}
+
+// Number of segments so that no chord strays more than SHAPE_TOLERANCE from the arc.
+// Counted in float and clamped before the int conversion, so huge or
+// non-finite radii still give 1..SHAPE_MAX_SEGMENTS.
+static int arc_segments(float radius, float sweep) {
+    sweep = SDL_fabsf(clamp_sweep(sweep));
+    // Keep small shapes round: at least 8 segments for a full circle
+    float n = SDL_ceilf(sweep * (4.0f / SHAPE_PI));
+    if (radius > SHAPE_TOLERANCE) {
+        float step = 2.0f * SDL_acosf(1.0f - SHAPE_TOLERANCE / radius);
+        float wanted = SDL_ceilf(sweep / step); // +inf when step underflows to 0
+        if (wanted > n) n = wanted;
+    }
+    if (!(n >= 1.0f)) n = 1.0f;
+    if (n > SHAPE_MAX_SEGMENTS) n = SHAPE_MAX_SEGMENTS;
+    return (int)n;
+}
+
+// Pie slice (or full disc when `full`) as a triangle fan around the center.
+static void fill_arc(lua_State* L, lua_SDL_Renderer* ud, float cx, float cy, float radius,
+                     float start, float sweep, bool full, SDL_FColor color) {
+    sweep = clamp_sweep(sweep);
+    if (radius <= 0.0f || sweep == 0.0f) {
+        return;
+    }
+    int n = arc_segments(radius * sdl_transform_scale(&ud->transform), sweep);
+    int rim = full ? n : n + 1;
+    int* idx;
+    int base;
+    SDL_Vertex* v = sdl_batch_alloc(L, ud, NULL, rim + 1, n * 3, &idx, &base);
+
+    set_vertex(&v[0], cx, cy, color);
+
+    // Walk the rim by rotating a unit vector instead of calling sin/cos per vertex
+    float step = sweep / (float)n;
+    float cs = SDL_cosf(step), sn = SDL_sinf(step);
+    float dx = SDL_cosf(start), dy = SDL_sinf(start);
+    for (int i = 0; i < rim; i++) {
+        set_vertex(&v[1 + i], cx + dx * radius, cy + dy * radius, color);
+        float ndx = dx * cs - dy * sn;
+        dy = dx * sn + dy * cs;
+        dx = ndx;
+    }
+
+    for (int i = 0; i < n; i++) {
+        *idx++ = base;
+        *idx++ = base + 1 + i;
+        *idx++ = base + 1 + (i + 1) % rim;
+    }
+}
+
+// Thick arc stroke (or full ring when `full`) as a strip of quads.
+static void stroke_arc(lua_State* L, lua_SDL_Renderer* ud, float cx, float cy, float radius,
+                       float start, float sweep, float thickness, bool full) {
+    sweep = clamp_sweep(sweep);
+    if (radius <= 0.0f || sweep == 0.0f || thickness <= 0.0f) {
+        return;
+    }
+    float r_in = radius - thickness * 0.5f;
+    float r_out = radius + thickness * 0.5f;
+    if (r_in < 0.0f) r_in = 0.0f;
+
+    int n = arc_segments(r_out * sdl_transform_scale(&ud->transform), sweep);
+    int rim = full ? n : n + 1;
+    int* idx;
+    int base;
+    SDL_Vertex* v = sdl_batch_alloc(L, ud, NULL, rim * 2, n * 6, &idx, &base);
+    SDL_FColor color = sdl_batch_draw_color(ud);
+
+    float step = sweep / (float)n;
+    float cs = SDL_cosf(step), sn = SDL_sinf(step);
+    float dx = SDL_cosf(start), dy = SDL_sinf(start);
+    for (int i = 0; i < rim; i++) {
+        set_vertex(&v[i * 2], cx + dx * r_out, cy + dy * r_out, color);
+        set_vertex(&v[i * 2 + 1], cx + dx * r_in, cy + dy * r_in, color);
+        float ndx = dx * cs - dy * sn;
+        dy = dx * sn + dy * cs;
+        dx = ndx;
+    }
+
+    for (int i = 0; i < n; i++) {
+        int o0 = base + i * 2;
+        int o1 = base + ((i + 1) % rim) * 2;
+        *idx++ = o0;
+        *idx++ = o0 + 1;
+        *idx++ = o1;
+        *idx++ = o0 + 1;
+        *idx++ = o1 + 1;
+        *idx++ = o1;
+    }
+}
+
+// Read a {{x=, y=}, ...} table into an array. The array is a userdata left on
+// the stack, so an error raised later (e.g. by sdl_batch_alloc) cannot leak it.
+static SDL_FPoint* read_points(lua_State* L, int arg, int* count) {
+    luaL_checktype(L, arg, LUA_TTABLE);
+    int n = (int)lua_rawlen(L, arg);
+    *count = n;
+    if (n == 0) {
+        return NULL;
+    }
+
+    SDL_FPoint* points = (SDL_FPoint*)lua_newuserdata(L, (size_t)n * sizeof(SDL_FPoint));
+    for (int i = 1; i <= n; i++) {
+        lua_rawgeti(L, arg, i);
+        if (!lua_istable(L, -1)) {
+            luaL_error(L, "Point %d is not a table", i);
+        }
+        lua_getfield(L, -1, "x");
+        lua_getfield(L, -2, "y");
+        if (!lua_isnumber(L, -2) || !lua_isnumber(L, -1)) {
+            luaL_error(L, "Point %d needs numeric x and y", i);
+        }
+        points[i-1].x = (float)lua_tonumber(L, -2);
+        points[i-1].y = (float)lua_tonumber(L, -1);
+        lua_pop(L, 3);
+    }
+    return points;
+}
+
+// Polyline with mitered joins; two vertices per point, one quad per segment.
+static void stroke_polyline(lua_State* L, lua_SDL_Renderer* ud, const SDL_FPoint* p, int count,
+                            float thickness, bool closed) {
+    int segments = closed ? count : count - 1;
+    float half = thickness * 0.5f;
+
+    // Lua owned like the points, freed by the GC even if sdl_batch_alloc raises
+    SDL_FPoint* normals = (SDL_FPoint*)lua_newuserdata(L, (size_t)segments * sizeof(SDL_FPoint));
+
+    SDL_FPoint last = { 0.0f, -1.0f };
+    for (int s = 0; s < segments; s++) {
+        const SDL_FPoint* a = &p[s];
+        const SDL_FPoint* b = &p[(s + 1) % count];
+        float dx = b->x - a->x, dy = b->y - a->y;
+        float len = SDL_sqrtf(dx * dx + dy * dy);
+        if (len > 1e-6f) {
+            last.x = -dy / len;
+            last.y = dx / len;
+        }
+        normals[s] = last; // zero-length segments reuse the previous direction
+    }
+
+    int* idx;
+    int base;
+    SDL_Vertex* v = sdl_batch_alloc(L, ud, NULL, count * 2, segments * 6, &idx, &base);
+    SDL_FColor color = sdl_batch_draw_color(ud);
+
+    for (int i = 0; i < count; i++) {
+        SDL_FPoint n_in, n_out;
+        if (closed) {
+            n_in = normals[(i + segments - 1) % segments];
+            n_out = normals[i % segments];
+        } else {
+            n_in = normals[i > 0 ? i - 1 : 0];
+            n_out = normals[i < segments ? i : segments - 1];
+        }
+
+        float mx = n_in.x + n_out.x, my = n_in.y + n_out.y;
+        float mlen = SDL_sqrtf(mx * mx + my * my);
+        float ox, oy;
+        if (mlen < 1e-6f) {
+            // Line folds back on itself: fall back to the outgoing normal
+            ox = n_out.x * half;
+            oy = n_out.y * half;
+        } else {
+            mx /= mlen;
+            my /= mlen;
+            float scale = half / (mx * n_out.x + my * n_out.y);
+            if (scale > half * SHAPE_MITER_LIMIT) scale = half * SHAPE_MITER_LIMIT;
+            ox = mx * scale;
+            oy = my * scale;
+        }
+
+        set_vertex(&v[i * 2], p[i].x + ox, p[i].y + oy, color);
+        set_vertex(&v[i * 2 + 1], p[i].x - ox, p[i].y - oy, color);
+    }
+
+    for (int s = 0; s < segments; s++) {
+        int a = base + s * 2;
+        int b = base + ((s + 1) % count) * 2;
+        *idx++ = a;
+        *idx++ = a + 1;
+        *idx++ = b;
+        *idx++ = a + 1;
+        *idx++ = b + 1;
+        *idx++ = b;
+    }
+    lua_pop(L, 1); // normals
+}
+
+// Filled disc (used by scenes and other batch producers).
+void sdl_shape_fill_circle(lua_State* L, lua_SDL_Renderer* ud, float cx, float cy, float radius, SDL_FColor color) {
+    fill_arc(L, ud, cx, cy, radius, 0.0f, 2.0f * SHAPE_PI, true, color);
+}
+
+// Axis aligned quad in the given color.
+void sdl_shape_fill_quad(lua_State* L, lua_SDL_Renderer* ud, const SDL_FRect* rect, SDL_FColor color) {
+    int* idx;
+    int base;
+    SDL_Vertex* v = sdl_batch_alloc(L, ud, NULL, 4, 6, &idx, &base);
+    set_vertex(&v[0], rect->x, rect->y, color);
+    set_vertex(&v[1], rect->x + rect->w, rect->y, color);
+    set_vertex(&v[2], rect->x + rect->w, rect->y + rect->h, color);
+    set_vertex(&v[3], rect->x, rect->y + rect->h, color);
+    idx[0] = base; idx[1] = base + 1; idx[2] = base + 2;
+    idx[3] = base; idx[4] = base + 2; idx[5] = base + 3;
+}
+
+// Draw a filled circle: sdl.render_fill_circle(renderer, x, y, radius)
+static int l_sdl_render_fill_circle(lua_State* L) {
+    lua_SDL_Renderer* ud = check_renderer(L, 1);
+    float x = (float)luaL_checknumber(L, 2);
+    float y = (float)luaL_checknumber(L, 3);
+    float radius = (float)luaL_checknumber(L, 4);
+
+    fill_arc(L, ud, x, y, radius, 0.0f, 2.0f * SHAPE_PI, true, sdl_batch_draw_color(ud));
+    return 0;
+}
+
+// Draw a circle outline: sdl.render_circle(renderer, x, y, radius, [thickness])
+static int l_sdl_render_circle(lua_State* L) {
+    lua_SDL_Renderer* ud = check_renderer(L, 1);
+    float x = (float)luaL_checknumber(L, 2);
+    float y = (float)luaL_checknumber(L, 3);
+    float radius = (float)luaL_checknumber(L, 4);
+    float thickness = (float)luaL_optnumber(L, 5, 1.0);
+
+    stroke_arc(L, ud, x, y, radius, 0.0f, 2.0f * SHAPE_PI, thickness, true);
+    return 0;
+}
+
+// Draw a filled pie slice: sdl.render_fill_arc(renderer, x, y, radius, start_angle, end_angle)
+// Angles are in radians, clockwise on screen starting from +x.
+static int l_sdl_render_fill_arc(lua_State* L) {
+    lua_SDL_Renderer* ud = check_renderer(L, 1);
+    float x = (float)luaL_checknumber(L, 2);
+    float y = (float)luaL_checknumber(L, 3);
+    float radius = (float)luaL_checknumber(L, 4);
+    float start = (float)luaL_checknumber(L, 5);
+    float end = (float)luaL_checknumber(L, 6);
+
+    fill_arc(L, ud, x, y, radius, start, end - start, false, sdl_batch_draw_color(ud));
+    return 0;
+}
+
+// Draw an arc outline: sdl.render_arc(renderer, x, y, radius, start_angle, end_angle, [thickness])
+static int l_sdl_render_arc(lua_State* L) {
+    lua_SDL_Renderer* ud = check_renderer(L, 1);
+    float x = (float)luaL_checknumber(L, 2);
+    float y = (float)luaL_checknumber(L, 3);
+    float radius = (float)luaL_checknumber(L, 4);
+    float start = (float)luaL_checknumber(L, 5);
+    float end = (float)luaL_checknumber(L, 6);
+    float thickness = (float)luaL_optnumber(L, 7, 1.0);
+
+    stroke_arc(L, ud, x, y, radius, start, end - start, thickness, false);
+    return 0;
+}
+
+// Draw a filled rounded rectangle: sdl.render_fill_rounded_rect(renderer, x, y, w, h, radius)
+static int l_sdl_render_fill_rounded_rect(lua_State* L) {
+    lua_SDL_Renderer* ud = check_renderer(L, 1);
+    float x = (float)luaL_checknumber(L, 2);
+    float y = (float)luaL_checknumber(L, 3);
+    float w = (float)luaL_checknumber(L, 4);
+    float h = (float)luaL_checknumber(L, 5);
+    float radius = (float)luaL_checknumber(L, 6);
+
+    if (w <= 0.0f || h <= 0.0f) {
+        return 0;
+    }
+    float max_radius = (w < h ? w : h) * 0.5f;
+    if (radius > max_radius) radius = max_radius;
+    if (radius < 0.0f) radius = 0.0f;
+
+    // Each corner is a quarter arc; a zero radius degenerates to a plain quad
+    int k = radius > 0.0f ? arc_segments(radius * sdl_transform_scale(&ud->transform), SHAPE_PI * 0.5f) : 0;
+    int per_corner = k + 1;
+    int rim = per_corner * 4;
+
+    int* idx;
+    int base;
+    SDL_Vertex* v = sdl_batch_alloc(L, ud, NULL, rim + 1, rim * 3, &idx, &base);
+    SDL_FColor color = sdl_batch_draw_color(ud);
+
+    set_vertex(&v[0], x + w * 0.5f, y + h * 0.5f, color);
+
+    const float corner_x[4] = { x + w - radius, x + w - radius, x + radius, x + radius };
+    const float corner_y[4] = { y + radius, y + h - radius, y + h - radius, y + radius };
+    float step = k > 0 ? (SHAPE_PI * 0.5f) / (float)k : 0.0f;
+    float cs = SDL_cosf(step), sn = SDL_sinf(step);
+    int vi = 1;
+    for (int c = 0; c < 4; c++) {
+        // Corner c sweeps from -90 + c*90 degrees
+        float dx = 0.0f, dy = -1.0f;
+        for (int r = 0; r < c; r++) {
+            float t = dx;
+            dx = -dy;
+            dy = t;
+        }
+        for (int i = 0; i <= k; i++) {
+            set_vertex(&v[vi++], corner_x[c] + dx * radius, corner_y[c] + dy * radius, color);
+            float ndx = dx * cs - dy * sn;
+            dy = dx * sn + dy * cs;
+            dx = ndx;
+        }
+    }
+
+    for (int i = 0; i < rim; i++) {
+        *idx++ = base;
+        *idx++ = base + 1 + i;
+        *idx++ = base + 1 + (i + 1) % rim;
+    }
+    return 0;
+}
+
+// Draw a filled convex polygon: sdl.render_fill_polygon(renderer, points_table)
+static int l_sdl_render_fill_polygon(lua_State* L) {
+    lua_SDL_Renderer* ud = check_renderer(L, 1);
+    int count;
+    const SDL_FPoint* points = read_points(L, 2, &count);
+    if (count < 3) {
+        return 0;
+    }
+
+    int* idx;
+    int base;
+    SDL_Vertex* v = sdl_batch_alloc(L, ud, NULL, count, (count - 2) * 3, &idx, &base);
+    SDL_FColor color = sdl_batch_draw_color(ud);
+    for (int i = 0; i < count; i++) {
+        set_vertex(&v[i], points[i].x, points[i].y, color);
+    }
+    for (int i = 1; i < count - 1; i++) {
+        *idx++ = base;
+        *idx++ = base + i;
+        *idx++ = base + i + 1;
+    }
+    return 0;
+}
+
+// Draw a line with thickness: sdl.render_thick_line(renderer, x1, y1, x2, y2, thickness)
+static int l_sdl_render_thick_line(lua_State* L) {
+    lua_SDL_Renderer* ud = check_renderer(L, 1);
+    float x1 = (float)luaL_checknumber(L, 2);
+    float y1 = (float)luaL_checknumber(L, 3);
+    float x2 = (float)luaL_checknumber(L, 4);
+    float y2 = (float)luaL_checknumber(L, 5);
+    float thickness = (float)luaL_checknumber(L, 6);
+
+    float dx = x2 - x1, dy = y2 - y1;
+    float len = SDL_sqrtf(dx * dx + dy * dy);
+    if (len < 1e-6f || thickness <= 0.0f) {
+        return 0;
+    }
+    float nx = -dy / len * thickness * 0.5f;
+    float ny = dx / len * thickness * 0.5f;
+
+    int* idx;
+    int base;
+    SDL_Vertex* v = sdl_batch_alloc(L, ud, NULL, 4, 6, &idx, &base);
+    SDL_FColor color = sdl_batch_draw_color(ud);
+    set_vertex(&v[0], x1 + nx, y1 + ny, color);
+    set_vertex(&v[1], x1 - nx, y1 - ny, color);
+    set_vertex(&v[2], x2 + nx, y2 + ny, color);
+    set_vertex(&v[3], x2 - nx, y2 - ny, color);
+    idx[0] = base; idx[1] = base + 1; idx[2] = base + 2;
+    idx[3] = base + 1; idx[4] = base + 3; idx[5] = base + 2;
+    return 0;
+}
+
+// Draw a polyline with thickness: sdl.render_thick_lines(renderer, points_table, thickness, [closed])
+static int l_sdl_render_thick_lines(lua_State* L) {
+    lua_SDL_Renderer* ud = check_renderer(L, 1);
+    float thickness = (float)luaL_checknumber(L, 3);
+    bool closed = lua_toboolean(L, 4);
+
+    int count;
+    const SDL_FPoint* points = read_points(L, 2, &count);
+    if (count < 2 || thickness <= 0.0f) {
+        return 0;
+    }
+
+    stroke_polyline(L, ud, points, count, thickness, closed && count > 2);
+    return 0;
+}
+
+static const struct luaL_Reg shapes_lib[] = {
+    {"render_fill_circle", l_sdl_render_fill_circle},
+    {"render_circle", l_sdl_render_circle},
+    {"render_fill_arc", l_sdl_render_fill_arc},
+    {"render_arc", l_sdl_render_arc},
+    {"render_fill_rounded_rect", l_sdl_render_fill_rounded_rect},
+    {"render_fill_polygon", l_sdl_render_fill_polygon},
+    {"render_thick_line", l_sdl_render_thick_line},
+    {"render_thick_lines", l_sdl_render_thick_lines},
+    {NULL, NULL}
+};
+
+// Add the shape functions to the sdl module table on top of the stack.
+void sdl_shapes_register(lua_State* L) {
+    luaL_setfuncs(L, shapes_lib, 0);
+}
@@ -0,0 +1,470 @@
+// sdl_text.c
+// Bitmap-font text: a glyph atlas texture built once, a layout cache keyed by
+// string, and text batches that submit many strings as one geometry call.
+#include "module_sdl.h"
+#include <stdlib.h>
+#include <string.h>
+
+static const char* FONT_MT = "sdl.font";
+static const char* TEXT_BATCH_MT = "sdl.text_batch";
+
+#define FONT_CACHE_BUCKETS 1024
+#define FONT_CACHE_MAX_ENTRIES 4096 // the whole cache is dropped when this is exceeded
+#define DEBUG_FONT_FIRST 32
+#define DEBUG_FONT_COUNT 96
+#define DEBUG_FONT_COLUMNS 16
+
+// One glyph quad of a laid out string, relative to the string origin.
+typedef struct {
+    float x0, y0, x1, y1;
+    float u0, v0, u1, v1;
+} text_quad;
+
+typedef struct text_layout {
+    struct text_layout* next;
+    Uint32 hash;
+    float scale;
+    size_t len;
+    char* text;
+    text_quad* quads;
+    int quad_count;
+} text_layout;
+
+typedef struct {
+    SDL_Texture* texture; // owned by the sdl.texture in the user value
+    int glyph_w, glyph_h;
+    int first, count, columns;
+    float tex_w, tex_h;
+    text_layout* buckets[FONT_CACHE_BUCKETS];
+    int cache_entries;
+} lua_SDL_Font;
+
+typedef struct {
+    lua_SDL_Font* font; // kept alive through the user value
+    SDL_Vertex* vertices;
+    int* indices;
+    int vertex_count, vertex_capacity;
+    int index_capacity; // indices are the fixed quad pattern, rebuilt on growth
+    SDL_FColor color;
+} lua_SDL_TextBatch;
+
+static void font_cache_clear(lua_SDL_Font* font) {
+    for (int i = 0; i < FONT_CACHE_BUCKETS; i++) {
+        text_layout* e = font->buckets[i];
+        while (e) {
+            text_layout* next = e->next;
+            free(e->text);
+            free(e->quads);
+            free(e);
+            e = next;
+        }
+        font->buckets[i] = NULL;
+    }
+    font->cache_entries = 0;
+}
+
+// FNV-1a over the bytes and the scale.
+static Uint32 layout_hash(const char* text, size_t len, float scale) {
+    Uint32 h = 2166136261u;
+    for (size_t i = 0; i < len; i++) {
+        h ^= (Uint8)text[i];
+        h *= 16777619u;
+    }
+    Uint32 bits;
+    memcpy(&bits, &scale, sizeof(bits));
+    h ^= bits;
+    h *= 16777619u;
+    return h;
+}
+
+// Find or build the layout of `text` at `scale`. Returns NULL on allocation failure.
+static text_layout* font_layout(lua_SDL_Font* font, const char* text, size_t len, float scale) {
+    Uint32 hash = layout_hash(text, len, scale);
+    text_layout** bucket = &font->buckets[hash % FONT_CACHE_BUCKETS];
+    for (text_layout* e = *bucket; e; e = e->next) {
+        if (e->hash == hash && e->len == len && e->scale == scale && memcmp(e->text, text, len) == 0) {
+            return e;
+        }
+    }
+
+    if (font->cache_entries >= FONT_CACHE_MAX_ENTRIES) {
+        font_cache_clear(font);
+    }
+
+    text_layout* e = (text_layout*)calloc(1, sizeof(text_layout));
+    if (!e) {
+        return NULL;
+    }
+    e->text = (char*)malloc(len + 1);
+    e->quads = len > 0 ? (text_quad*)malloc(len * sizeof(text_quad)) : NULL;
+    if (!e->text || (len > 0 && !e->quads)) {
+        free(e->text);
+        free(e->quads);
+        free(e);
+        return NULL;
+    }
+    memcpy(e->text, text, len);
+    e->text[len] = '\0';
+    e->hash = hash;
+    e->len = len;
+    e->scale = scale;
+
+    float gw = font->glyph_w * scale;
+    float gh = font->glyph_h * scale;
+    float pen_x = 0.0f, pen_y = 0.0f;
+    for (size_t i = 0; i < len; i++) {
+        int c = (Uint8)text[i];
+        if (c == '\n') {
+            pen_x = 0.0f;
+            pen_y += gh;
+            continue;
+        }
+        if (c != ' ') {
+            int glyph = c - font->first;
+            if (glyph < 0 || glyph >= font->count) {
+                glyph = '?' - font->first; // unknown glyphs render as '?'
+            }
+            if (glyph >= 0 && glyph < font->count) {
+                int col = glyph % font->columns;
+                int row = glyph / font->columns;
+                text_quad* q = &e->quads[e->quad_count++];
+                q->x0 = pen_x;
+                q->y0 = pen_y;
+                q->x1 = pen_x + gw;
+                q->y1 = pen_y + gh;
+                q->u0 = (float)(col * font->glyph_w) / font->tex_w;
+                q->v0 = (float)(row * font->glyph_h) / font->tex_h;
+                q->u1 = (float)((col + 1) * font->glyph_w) / font->tex_w;
+                q->v1 = (float)((row + 1) * font->glyph_h) / font->tex_h;
+            }
+        }
+        pen_x += gw;
+    }
+
+    e->next = *bucket;
+    *bucket = e;
+    font->cache_entries++;
+    return e;
+}
+
+// Write the quads of a layout at (x, y) as 4 vertices each.
+static void emit_layout(SDL_Vertex* v, const text_layout* layout, float x, float y, SDL_FColor color) {
+    for (int i = 0; i < layout->quad_count; i++) {
+        const text_quad* q = &layout->quads[i];
+        v[0].position.x = x + q->x0; v[0].position.y = y + q->y0;
+        v[0].tex_coord.x = q->u0;    v[0].tex_coord.y = q->v0;
+        v[1].position.x = x + q->x1; v[1].position.y = y + q->y0;
+        v[1].tex_coord.x = q->u1;    v[1].tex_coord.y = q->v0;
+        v[2].position.x = x + q->x1; v[2].position.y = y + q->y1;
+        v[2].tex_coord.x = q->u1;    v[2].tex_coord.y = q->v1;
+        v[3].position.x = x + q->x0; v[3].position.y = y + q->y1;
+        v[3].tex_coord.x = q->u0;    v[3].tex_coord.y = q->v1;
+        v[0].color = v[1].color = v[2].color = v[3].color = color;
+        v += 4;
+    }
+}
+
+static lua_SDL_Font* check_font(lua_State* L, int idx) {
+    lua_SDL_Font* font = (lua_SDL_Font*)luaL_checkudata(L, idx, FONT_MT);
+    if (!font->texture) {
+        luaL_error(L, "Invalid font (already destroyed)");
+    }
+    return font;
+}
+
+static lua_SDL_TextBatch* check_text_batch(lua_State* L, int idx) {
+    return (lua_SDL_TextBatch*)luaL_checkudata(L, idx, TEXT_BATCH_MT);
+}
+
+static int font_gc(lua_State* L) {
+    lua_SDL_Font* font = (lua_SDL_Font*)luaL_checkudata(L, 1, FONT_MT);
+    font_cache_clear(font);
+    font->texture = NULL;
+    return 0;
+}
+
+static int text_batch_gc(lua_State* L) {
+    lua_SDL_TextBatch* batch = check_text_batch(L, 1);
+    free(batch->vertices);
+    free(batch->indices);
+    batch->vertices = NULL;
+    batch->indices = NULL;
+    batch->vertex_count = batch->vertex_capacity = batch->index_capacity = 0;
+    return 0;
+}
+
+// Render the built-in debug font into a 16x6 glyph grid on a target texture.
+static SDL_Texture* build_debug_font_atlas(lua_State* L, lua_SDL_Renderer* ud) {
+    const int size = SDL_DEBUG_TEXT_FONT_CHARACTER_SIZE;
+    int rows = (DEBUG_FONT_COUNT + DEBUG_FONT_COLUMNS - 1) / DEBUG_FONT_COLUMNS;
+    SDL_Texture* atlas = SDL_CreateTexture(ud->renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET,
+                                           DEBUG_FONT_COLUMNS * size, rows * size);
+    if (!atlas) {
+        luaL_error(L, "Failed to create font atlas: %s", SDL_GetError());
+    }
+    SDL_SetTextureBlendMode(atlas, SDL_BLENDMODE_BLEND);
+    SDL_SetTextureScaleMode(atlas, SDL_SCALEMODE_NEAREST);
+
+    sdl_batch_flush(L, ud);
+    SDL_Texture* old_target = SDL_GetRenderTarget(ud->renderer);
+    Uint8 r, g, b, a;
+    SDL_GetRenderDrawColor(ud->renderer, &r, &g, &b, &a);
+
+    bool ok = SDL_SetRenderTarget(ud->renderer, atlas);
+    if (ok) {
+        SDL_SetRenderDrawColor(ud->renderer, 0, 0, 0, 0);
+        SDL_RenderClear(ud->renderer);
+        SDL_SetRenderDrawColor(ud->renderer, 255, 255, 255, 255);
+        for (int i = 0; i < DEBUG_FONT_COUNT; i++) {
+            char glyph[2] = { (char)(DEBUG_FONT_FIRST + i), '\0' };
+            SDL_RenderDebugText(ud->renderer, (float)((i % DEBUG_FONT_COLUMNS) * size),
+                                (float)((i / DEBUG_FONT_COLUMNS) * size), glyph);
+        }
+    }
+
+    SDL_SetRenderTarget(ud->renderer, old_target);
+    SDL_SetRenderDrawColor(ud->renderer, r, g, b, a);
+    if (!ok) {
+        SDL_DestroyTexture(atlas);
+        luaL_error(L, "Failed to render font atlas: %s", SDL_GetError());
+    }
+    return atlas;
+}
+
+// Create a font: sdl.create_font(renderer) uses the built-in debug font,
+// sdl.create_font(renderer, texture, glyph_w, glyph_h, [first_char], [columns]) uses a glyph grid texture.
+static int l_sdl_create_font(lua_State* L) {
+    lua_SDL_Renderer* ud = lua_check_SDL_Renderer(L, 1);
+
+    lua_SDL_Font* font = (lua_SDL_Font*)lua_newuserdata(L, sizeof(lua_SDL_Font));
+    memset(font, 0, sizeof(lua_SDL_Font));
+    luaL_setmetatable(L, FONT_MT);
+    int font_idx = lua_gettop(L);
+
+    if (lua_isnoneornil(L, 2)) {
+        SDL_Texture* atlas = build_debug_font_atlas(L, ud);
+        lua_push_SDL_Texture(L, atlas); // the texture userdata owns the atlas
+        font->glyph_w = font->glyph_h = SDL_DEBUG_TEXT_FONT_CHARACTER_SIZE;
+        font->first = DEBUG_FONT_FIRST;
+        font->count = DEBUG_FONT_COUNT;
+        font->columns = DEBUG_FONT_COLUMNS;
+        font->texture = atlas;
+    } else {
+        lua_SDL_Texture* tex = lua_check_SDL_Texture(L, 2);
+        font->glyph_w = (int)luaL_checkinteger(L, 3);
+        font->glyph_h = (int)luaL_checkinteger(L, 4);
+        font->first = (int)luaL_optinteger(L, 5, DEBUG_FONT_FIRST);
+        if (font->glyph_w <= 0 || font->glyph_h <= 0) {
+            luaL_error(L, "Glyph size must be positive");
+        }
+        float w, h;
+        if (!SDL_GetTextureSize(tex->texture, &w, &h)) {
+            luaL_error(L, "Failed to get font texture size: %s", SDL_GetError());
+        }
+        font->columns = (int)luaL_optinteger(L, 6, (int)w / font->glyph_w);
+        if (font->columns <= 0) {
+            luaL_error(L, "Font texture is smaller than one glyph");
+        }
+        font->count = font->columns * ((int)h / font->glyph_h);
+        font->texture = tex->texture;
+        lua_pushvalue(L, 2);
+    }
+    lua_setuservalue(L, font_idx);
+
+    float w, h;
+    SDL_GetTextureSize(font->texture, &w, &h);
+    font->tex_w = w;
+    font->tex_h = h;
+    return 1;
+}
+
+// Measure text: sdl.font_text_size(font, text, [scale]) -> w, h
+static int l_sdl_font_text_size(lua_State* L) {
+    lua_SDL_Font* font = check_font(L, 1);
+    size_t len;
+    const char* text = luaL_checklstring(L, 2, &len);
+    float scale = (float)luaL_optnumber(L, 3, 1.0);
+
+    int columns = 0, max_columns = 0, lines = len > 0 ? 1 : 0;
+    for (size_t i = 0; i < len; i++) {
+        if (text[i] == '\n') {
+            lines++;
+            columns = 0;
+        } else if (++columns > max_columns) {
+            max_columns = columns;
+        }
+    }
+    lua_pushnumber(L, max_columns * font->glyph_w * scale);
+    lua_pushnumber(L, lines * font->glyph_h * scale);
+    return 2;
+}
+
+// Draw text through the renderer batch: sdl.render_text(renderer, font, x, y, text, [scale])
+// Uses the current draw color; consecutive calls with one font become one geometry call.
+static int l_sdl_render_text(lua_State* L) {
+    lua_SDL_Renderer* ud = lua_check_SDL_Renderer(L, 1);
+    lua_SDL_Font* font = check_font(L, 2);
+    float x = (float)luaL_checknumber(L, 3);
+    float y = (float)luaL_checknumber(L, 4);
+    size_t len;
+    const char* text = luaL_checklstring(L, 5, &len);
+    float scale = (float)luaL_optnumber(L, 6, 1.0);
+
+    text_layout* layout = font_layout(font, text, len, scale);
+    if (!layout) {
+        luaL_error(L, "Failed to allocate memory for text layout");
+    }
+    if (layout->quad_count == 0) {
+        return 0;
+    }
+
+    int* idx;
+    int base;
+    SDL_Vertex* v = sdl_batch_alloc(L, ud, font->texture, layout->quad_count * 4, layout->quad_count * 6, &idx, &base);
+    emit_layout(v, layout, x, y, sdl_batch_draw_color(ud));
+    for (int i = 0; i < layout->quad_count; i++) {
+        int q = base + i * 4;
+        *idx++ = q; *idx++ = q + 1; *idx++ = q + 2;
+        *idx++ = q; *idx++ = q + 2; *idx++ = q + 3;
+    }
+    return 0;
+}
+
+// Create a text batch: sdl.create_text_batch(font)
+static int l_sdl_create_text_batch(lua_State* L) {
+    lua_SDL_Font* font = check_font(L, 1);
+
+    lua_SDL_TextBatch* batch = (lua_SDL_TextBatch*)lua_newuserdata(L, sizeof(lua_SDL_TextBatch));
+    memset(batch, 0, sizeof(lua_SDL_TextBatch));
+    batch->font = font;
+    batch->color.r = batch->color.g = batch->color.b = batch->color.a = 1.0f;
+    luaL_setmetatable(L, TEXT_BATCH_MT);
+    lua_pushvalue(L, 1);
+    lua_setuservalue(L, -2); // keep the font alive
+    return 1;
+}
+
+// Set the color of text added afterwards: sdl.text_batch_set_color(batch, r, g, b, [a])
+static int l_sdl_text_batch_set_color(lua_State* L) {
+    lua_SDL_TextBatch* batch = check_text_batch(L, 1);
+    int r = (int)luaL_checkinteger(L, 2);
+    int g = (int)luaL_checkinteger(L, 3);
+    int b = (int)luaL_checkinteger(L, 4);
+    int a = (int)luaL_optinteger(L, 5, 255);
+
+    batch->color.r = SDL_clamp(r, 0, 255) / 255.0f;
+    batch->color.g = SDL_clamp(g, 0, 255) / 255.0f;
+    batch->color.b = SDL_clamp(b, 0, 255) / 255.0f;
+    batch->color.a = SDL_clamp(a, 0, 255) / 255.0f;
+    return 0;
+}
+
+// Remove all text from the batch (keeps its memory): sdl.text_batch_clear(batch)
+static int l_sdl_text_batch_clear(lua_State* L) {
+    lua_SDL_TextBatch* batch = check_text_batch(L, 1);
+    batch->vertex_count = 0;
+    return 0;
+}
+
+// Append a string: sdl.text_batch_add(batch, x, y, text, [scale])
+static int l_sdl_text_batch_add(lua_State* L) {
+    lua_SDL_TextBatch* batch = check_text_batch(L, 1);
+    float x = (float)luaL_checknumber(L, 2);
+    float y = (float)luaL_checknumber(L, 3);
+    size_t len;
+    const char* text = luaL_checklstring(L, 4, &len);
+    float scale = (float)luaL_optnumber(L, 5, 1.0);
+
+    text_layout* layout = font_layout(batch->font, text, len, scale);
+    if (!layout) {
+        luaL_error(L, "Failed to allocate memory for text layout");
+    }
+
+    int needed = batch->vertex_count + layout->quad_count * 4;
+    if (needed > batch->vertex_capacity) {
+        int cap = batch->vertex_capacity > 0 ? batch->vertex_capacity : 1024;
+        while (cap < needed) cap *= 2;
+        SDL_Vertex* vertices = (SDL_Vertex*)realloc(batch->vertices, cap * sizeof(SDL_Vertex));
+        if (!vertices) {
+            luaL_error(L, "Failed to allocate memory for text vertices");
+        }
+        batch->vertices = vertices;
+        batch->vertex_capacity = cap;
+    }
+
+    emit_layout(batch->vertices + batch->vertex_count, layout, x, y, batch->color);
+    batch->vertex_count = needed;
+    return 0;
+}
+
+// Draw every string in the batch with one geometry call: sdl.render_text_batch(renderer, batch)
+static int l_sdl_render_text_batch(lua_State* L) {
+    lua_SDL_Renderer* ud = lua_check_SDL_Renderer(L, 1);
+    lua_SDL_TextBatch* batch = check_text_batch(L, 2);
+    if (batch->vertex_count == 0) {
+        return 0;
+    }
+
+    int quads = batch->vertex_count / 4;
+    if (quads * 6 > batch->index_capacity) {
+        int* indices = (int*)realloc(batch->indices, batch->vertex_capacity / 4 * 6 * sizeof(int));
+        if (!indices) {
+            luaL_error(L, "Failed to allocate memory for text indices");
+        }
+        batch->indices = indices;
+        batch->index_capacity = batch->vertex_capacity / 4 * 6;
+        for (int i = 0; i < batch->index_capacity / 6; i++) {
+            int q = i * 4;
+            int* idx = &indices[i * 6];
+            idx[0] = q; idx[1] = q + 1; idx[2] = q + 2;
+            idx[3] = q; idx[4] = q + 2; idx[5] = q + 3;
+        }
+    }
+
+    if (!sdl_transform_is_identity(&ud->transform)) {
+        // Copy into the renderer batch so the transform is applied there
+        int* idx;
+        int base;
+        SDL_Vertex* v = sdl_batch_alloc(L, ud, batch->font->texture, batch->vertex_count, quads * 6, &idx, &base);
+        memcpy(v, batch->vertices, batch->vertex_count * sizeof(SDL_Vertex));
+        for (int i = 0; i < quads * 6; i++) {
+            idx[i] = base + batch->indices[i];
+        }
+        sdl_batch_flush(L, ud);
+        return 0;
+    }
+
+    sdl_batch_flush(L, ud);
+    if (!SDL_RenderGeometry(ud->renderer, batch->font->texture, batch->vertices, batch->vertex_count,
+                            batch->indices, quads * 6)) {
+        luaL_error(L, "Failed to render text batch: %s", SDL_GetError());
+    }
+    return 0;
+}
+
+static const struct luaL_Reg text_lib[] = {
+    {"create_font", l_sdl_create_font},
+    {"font_text_size", l_sdl_font_text_size},
+    {"render_text", l_sdl_render_text},
+    {"create_text_batch", l_sdl_create_text_batch},
+    {"text_batch_set_color", l_sdl_text_batch_set_color},
+    {"text_batch_clear", l_sdl_text_batch_clear},
+    {"text_batch_add", l_sdl_text_batch_add},
+    {"render_text_batch", l_sdl_render_text_batch},
+    {NULL, NULL}
+};
+
+// Create the font/text batch metatables and add the text functions to the sdl module table.
+void sdl_text_register(lua_State* L) {
+    luaL_newmetatable(L, FONT_MT);
+    lua_pushcfunction(L, font_gc);
+    lua_setfield(L, -2, "__gc");
+    lua_pop(L, 1);
+
+    luaL_newmetatable(L, TEXT_BATCH_MT);
+    lua_pushcfunction(L, text_batch_gc);
+    lua_setfield(L, -2, "__gc");
+    lua_pop(L, 1);
+
+    luaL_setfuncs(L, text_lib, 0);
+}
@@ -0,0 +1,400 @@
+// sdl_tilemap.c
+// Tilemap layer: a grid of tile ids drawn from an atlas texture. The map is
+// split into square chunks whose vertices are built on first use and rebuilt
+// only after one of their tiles changes. Drawing culls chunks against the
+// view and submits one geometry call per visible chunk; with a transform only
+// the positions are copied and transformed, colors and uvs come from the cache.
+#include "module_sdl.h"
+#include <stdlib.h>
+#include <string.h>
+
+static const char* TILEMAP_MT = "sdl.tilemap";
+
+#define TILEMAP_DEFAULT_CHUNK 32
+
+typedef struct {
+    SDL_Vertex* vertices; // 4 per non-empty tile, map space
+    int quads;
+    int capacity;         // quads the vertex storage holds
+    bool built;
+    bool dirty;
+} tilemap_chunk;
+
+typedef struct {
+    SDL_Texture* texture; // atlas; the texture userdata is the uservalue
+    float tex_w, tex_h;
+    int columns;          // tiles per atlas row
+    int tile_count;       // tiles in the atlas
+    int width, height;    // in tiles
+    int tile_w, tile_h;   // in pixels
+    int chunk_size;       // tiles per chunk side
+    int chunks_x, chunks_y;
+    Uint16* tiles;        // 0 = empty, n = atlas tile n - 1
+    tilemap_chunk* chunks;
+    int* indices;         // shared quad indices for a full chunk
+} lua_SDL_Tilemap;
+
+static lua_SDL_Tilemap* check_tilemap(lua_State* L, int idx) {
+    return (lua_SDL_Tilemap*)luaL_checkudata(L, idx, TILEMAP_MT);
+}
+
+static int tilemap_gc(lua_State* L) {
+    lua_SDL_Tilemap* map = check_tilemap(L, 1);
+    if (map->chunks) {
+        for (int i = 0; i < map->chunks_x * map->chunks_y; i++) {
+            free(map->chunks[i].vertices);
+        }
+    }
+    free(map->chunks);
+    free(map->tiles);
+    free(map->indices);
+    map->chunks = NULL;
+    map->tiles = NULL;
+    map->indices = NULL;
+    return 0;
+}
+
+static void check_tile(lua_State* L, const lua_SDL_Tilemap* map, int x, int y) {
+    if (x < 0 || y < 0 || x >= map->width || y >= map->height) {
+        luaL_error(L, "Tile (%d, %d) outside the %dx%d map", x, y, map->width, map->height);
+    }
+}
+
+static Uint16 check_tile_id(lua_State* L, const lua_SDL_Tilemap* map, int arg) {
+    lua_Integer id = luaL_checkinteger(L, arg);
+    if (id < 0 || id > map->tile_count) {
+        luaL_error(L, "Tile id %d outside the atlas (0..%d)", (int)id, map->tile_count);
+    }
+    return (Uint16)id;
+}
+
+static inline void mark_dirty(lua_SDL_Tilemap* map, int x, int y) {
+    map->chunks[(y / map->chunk_size) * map->chunks_x + x / map->chunk_size].dirty = true;
+}
+
+// Create a tilemap: sdl.create_tilemap(atlas, width, height, tile_w, tile_h, [chunk_size])
+// Width/height are in tiles; atlas tiles are numbered from 1, row by row, 0 is empty.
+static int l_sdl_create_tilemap(lua_State* L) {
+    lua_SDL_Texture* tex = lua_check_SDL_Texture(L, 1);
+    lua_Integer width = luaL_checkinteger(L, 2);
+    lua_Integer height = luaL_checkinteger(L, 3);
+    int tile_w = (int)luaL_checkinteger(L, 4);
+    int tile_h = (int)luaL_checkinteger(L, 5);
+    int chunk_size = (int)luaL_optinteger(L, 6, TILEMAP_DEFAULT_CHUNK);
+
+    if (width < 1 || height < 1 || width * height > 0x7fffffff / (lua_Integer)sizeof(Uint16)) {
+        luaL_error(L, "Invalid tilemap size %dx%d", (int)width, (int)height);
+    }
+    if (tile_w <= 0 || tile_h <= 0) {
+        luaL_error(L, "Tile size must be positive");
+    }
+    if (chunk_size < 1 || chunk_size > 128) {
+        luaL_error(L, "Chunk size must be between 1 and 128");
+    }
+
+    float tex_w, tex_h;
+    if (!SDL_GetTextureSize(tex->texture, &tex_w, &tex_h)) {
+        luaL_error(L, "Failed to get atlas texture size: %s", SDL_GetError());
+    }
+    int columns = (int)tex_w / tile_w;
+    int rows = (int)tex_h / tile_h;
+    if (columns <= 0 || rows <= 0) {
+        luaL_error(L, "Atlas texture is smaller than one tile");
+    }
+
+    lua_SDL_Tilemap* map = (lua_SDL_Tilemap*)lua_newuserdata(L, sizeof(lua_SDL_Tilemap));
+    memset(map, 0, sizeof(lua_SDL_Tilemap));
+    luaL_setmetatable(L, TILEMAP_MT);
+    lua_pushvalue(L, 1);
+    lua_setuservalue(L, -2); // keep the atlas alive
+
+    map->texture = tex->texture;
+    map->tex_w = tex_w;
+    map->tex_h = tex_h;
+    map->columns = columns;
+    map->tile_count = columns * rows < 0xffff ? columns * rows : 0xffff;
+    map->width = (int)width;
+    map->height = (int)height;
+    map->tile_w = tile_w;
+    map->tile_h = tile_h;
+    map->chunk_size = chunk_size;
+    map->chunks_x = (map->width + chunk_size - 1) / chunk_size;
+    map->chunks_y = (map->height + chunk_size - 1) / chunk_size;
+
+    int quads = chunk_size * chunk_size;
+    map->tiles = (Uint16*)calloc((size_t)width * height, sizeof(Uint16));
+    map->chunks = (tilemap_chunk*)calloc((size_t)map->chunks_x * map->chunks_y, sizeof(tilemap_chunk));
+    map->indices = (int*)malloc((size_t)quads * 6 * sizeof(int));
+    if (!map->tiles || !map->chunks || !map->indices) {
+        luaL_error(L, "Failed to allocate %dx%d tilemap", map->width, map->height);
+    }
+    for (int q = 0; q < quads; q++) {
+        int* idx = map->indices + q * 6;
+        idx[0] = q * 4;     idx[1] = q * 4 + 1; idx[2] = q * 4 + 2;
+        idx[3] = q * 4;     idx[4] = q * 4 + 2; idx[5] = q * 4 + 3;
+    }
+    return 1;
+}
+
+// Set one tile (0-based tile coordinates): sdl.tilemap_set(map, x, y, id)
+static int l_sdl_tilemap_set(lua_State* L) {
+    lua_SDL_Tilemap* map = check_tilemap(L, 1);
+    int x = (int)luaL_checkinteger(L, 2);
+    int y = (int)luaL_checkinteger(L, 3);
+    check_tile(L, map, x, y);
+    Uint16 id = check_tile_id(L, map, 4);
+
+    Uint16* tile = &map->tiles[(size_t)y * map->width + x];
+    if (*tile != id) {
+        *tile = id;
+        mark_dirty(map, x, y);
+    }
+    return 0;
+}
+
+// sdl.tilemap_get(map, x, y) -> id
+static int l_sdl_tilemap_get(lua_State* L) {
+    lua_SDL_Tilemap* map = check_tilemap(L, 1);
+    int x = (int)luaL_checkinteger(L, 2);
+    int y = (int)luaL_checkinteger(L, 3);
+    check_tile(L, map, x, y);
+    lua_pushinteger(L, map->tiles[(size_t)y * map->width + x]);
+    return 1;
+}
+
+// Clip [start, start + size) to [0, limit) in 64-bit, so no Lua integer
+// can overflow or wrap into the map. False when nothing is left.
+static bool clip_span(lua_Integer start, lua_Integer size, int limit, int* lo, int* hi) {
+    if (size <= 0) {
+        return false;
+    }
+    if (start < 0) {
+        size += start; // opposite signs, cannot overflow
+        start = 0;
+    }
+    if (size <= 0 || start >= limit) {
+        return false;
+    }
+    *lo = (int)start;
+    *hi = size > limit - start ? limit : (int)(start + size);
+    return true;
+}
+
+// Fill a rectangle of tiles (clipped to the map): sdl.tilemap_fill(map, x, y, w, h, id)
+static int l_sdl_tilemap_fill(lua_State* L) {
+    lua_SDL_Tilemap* map = check_tilemap(L, 1);
+    lua_Integer left = luaL_checkinteger(L, 2);
+    lua_Integer top = luaL_checkinteger(L, 3);
+    lua_Integer w = luaL_checkinteger(L, 4);
+    lua_Integer h = luaL_checkinteger(L, 5);
+    Uint16 id = check_tile_id(L, map, 6);
+
+    int x0, x1, y0, y1;
+    if (!clip_span(left, w, map->width, &x0, &x1) || !clip_span(top, h, map->height, &y0, &y1)) {
+        return 0;
+    }
+    for (int y = y0; y < y1; y++) {
+        Uint16* row = map->tiles + (size_t)y * map->width;
+        for (int x = x0; x < x1; x++) {
+            row[x] = id;
+        }
+    }
+    // Mark every chunk the rectangle touches
+    for (int cy = y0 / map->chunk_size; cy <= (y1 - 1) / map->chunk_size; cy++) {
+        for (int cx = x0 / map->chunk_size; cx <= (x1 - 1) / map->chunk_size; cx++) {
+            map->chunks[cy * map->chunks_x + cx].dirty = true;
+        }
+    }
+    return 0;
+}
+
+// Replace all tiles from a row-major array of width*height ids: sdl.tilemap_load(map, ids)
+// Every id is checked before any tile is written, so a bad id leaves the map as it was.
+static int l_sdl_tilemap_load(lua_State* L) {
+    lua_SDL_Tilemap* map = check_tilemap(L, 1);
+    luaL_checktype(L, 2, LUA_TTABLE);
+    lua_Integer count = (lua_Integer)map->width * map->height;
+    if ((lua_Integer)lua_rawlen(L, 2) != count) {
+        luaL_error(L, "Expected %d tile ids, got %d", (int)count, (int)lua_rawlen(L, 2));
+    }
+    for (lua_Integer i = 0; i < count; i++) {
+        lua_rawgeti(L, 2, i + 1);
+        check_tile_id(L, map, -1);
+        lua_pop(L, 1);
+    }
+    for (lua_Integer i = 0; i < count; i++) {
+        lua_rawgeti(L, 2, i + 1);
+        map->tiles[i] = (Uint16)lua_tointeger(L, -1);
+        lua_pop(L, 1);
+    }
+    for (int i = 0; i < map->chunks_x * map->chunks_y; i++) {
+        map->chunks[i].dirty = true;
+    }
+    return 0;
+}
+
+// sdl.tilemap_size(map) -> width, height, tile_w, tile_h
+static int l_sdl_tilemap_size(lua_State* L) {
+    lua_SDL_Tilemap* map = check_tilemap(L, 1);
+    lua_pushinteger(L, map->width);
+    lua_pushinteger(L, map->height);
+    lua_pushinteger(L, map->tile_w);
+    lua_pushinteger(L, map->tile_h);
+    return 4;
+}
+
+// Rebuild the cached vertices of a chunk from its tiles. Storage is sized to
+// the non-empty tiles, so sparse layers of huge maps stay small.
+static void build_chunk(lua_State* L, lua_SDL_Tilemap* map, int cx, int cy) {
+    tilemap_chunk* chunk = &map->chunks[cy * map->chunks_x + cx];
+    int tx0 = cx * map->chunk_size, ty0 = cy * map->chunk_size;
+    int tx1 = SDL_min(tx0 + map->chunk_size, map->width);
+    int ty1 = SDL_min(ty0 + map->chunk_size, map->height);
+
+    int needed = 0;
+    for (int ty = ty0; ty < ty1; ty++) {
+        const Uint16* row = map->tiles + (size_t)ty * map->width;
+        for (int tx = tx0; tx < tx1; tx++) {
+            needed += row[tx] != 0;
+        }
+    }
+    if (needed > chunk->capacity) {
+        SDL_Vertex* vertices = (SDL_Vertex*)realloc(chunk->vertices, (size_t)needed * 4 * sizeof(SDL_Vertex));
+        if (!vertices) {
+            luaL_error(L, "Failed to allocate tilemap chunk");
+        }
+        chunk->vertices = vertices;
+        chunk->capacity = needed;
+    }
+
+    const SDL_FColor white = { 1.0f, 1.0f, 1.0f, 1.0f };
+    const float du = map->tile_w / map->tex_w, dv = map->tile_h / map->tex_h;
+    SDL_Vertex* v = chunk->vertices;
+    int quads = 0;
+
+    for (int ty = ty0; ty < ty1; ty++) {
+        const Uint16* row = map->tiles + (size_t)ty * map->width;
+        for (int tx = tx0; tx < tx1; tx++) {
+            int id = row[tx];
+            if (id == 0) {
+                continue;
+            }
+            float u0 = ((id - 1) % map->columns) * du, v0 = ((id - 1) / map->columns) * dv;
+            float x0 = (float)tx * map->tile_w, y0 = (float)ty * map->tile_h;
+            float x1 = x0 + map->tile_w, y1 = y0 + map->tile_h;
+
+            v[0].position.x = x0; v[0].position.y = y0; v[0].tex_coord.x = u0;      v[0].tex_coord.y = v0;
+            v[1].position.x = x1; v[1].position.y = y0; v[1].tex_coord.x = u0 + du; v[1].tex_coord.y = v0;
+            v[2].position.x = x1; v[2].position.y = y1; v[2].tex_coord.x = u0 + du; v[2].tex_coord.y = v0 + dv;
+            v[3].position.x = x0; v[3].position.y = y1; v[3].tex_coord.x = u0;      v[3].tex_coord.y = v0 + dv;
+            v[0].color = v[1].color = v[2].color = v[3].color = white;
+            v += 4;
+            quads++;
+        }
+    }
+    chunk->quads = quads;
+    chunk->built = true;
+    chunk->dirty = false;
+}
+
+// Tile index containing map coordinate v, clamped in float to [-1, limit] so
+// huge or non-finite view bounds never reach the int conversion (NaN gives -1).
+static int tile_index(float v, int tile_size, int limit) {
+    float t = SDL_floorf(v / (float)tile_size);
+    if (!(t >= -1.0f)) {
+        return -1;
+    }
+    return t < (float)limit ? (int)t : limit;
+}
+
+// Draw the visible part of a tilemap with its top-left corner at (x, y):
+// sdl.render_tilemap(renderer, map, [x], [y]) -> chunks drawn
+static int l_sdl_render_tilemap(lua_State* L) {
+    lua_SDL_Renderer* ud = lua_check_SDL_Renderer(L, 1);
+    lua_SDL_Tilemap* map = check_tilemap(L, 2);
+    float ox = (float)luaL_optnumber(L, 3, 0.0);
+    float oy = (float)luaL_optnumber(L, 4, 0.0);
+
+    if (!ud->renderer) {
+        luaL_error(L, "No renderer available");
+    }
+    sdl_batch_flush(L, ud);
+
+    // Visible tile range in map space
+    SDL_FRect view;
+    int tx0 = 0, ty0 = 0, tx1 = map->width - 1, ty1 = map->height - 1;
+    if (sdl_view_bounds(ud, &view)) {
+        tx0 = SDL_max(tx0, tile_index(view.x - ox, map->tile_w, map->width));
+        ty0 = SDL_max(ty0, tile_index(view.y - oy, map->tile_h, map->height));
+        tx1 = SDL_min(tx1, tile_index(view.x + view.w - ox, map->tile_w, map->width));
+        ty1 = SDL_min(ty1, tile_index(view.y + view.h - oy, map->tile_h, map->height));
+    }
+    if (tx0 > tx1 || ty0 > ty1) {
+        lua_pushinteger(L, 0);
+        return 1;
+    }
+
+    // Map space -> screen: the renderer transform after translating by (ox, oy)
+    sdl_transform t = ud->transform;
+    t.tx += t.a * ox + t.c * oy;
+    t.ty += t.b * ox + t.d * oy;
+    bool identity = sdl_transform_is_identity(&t);
+
+    int drawn = 0;
+    for (int cy = ty0 / map->chunk_size; cy <= ty1 / map->chunk_size; cy++) {
+        for (int cx = tx0 / map->chunk_size; cx <= tx1 / map->chunk_size; cx++) {
+            tilemap_chunk* chunk = &map->chunks[cy * map->chunks_x + cx];
+            if (!chunk->built || chunk->dirty) {
+                build_chunk(L, map, cx, cy);
+            }
+            if (chunk->quads == 0) {
+                continue;
+            }
+
+            int count = chunk->quads * 4;
+            bool ok;
+            if (identity) {
+                ok = SDL_RenderGeometry(ud->renderer, map->texture, chunk->vertices, count,
+                                        map->indices, chunk->quads * 6);
+            } else {
+                SDL_FPoint* points = sdl_batch_points(L, ud, count);
+                for (int i = 0; i < count; i++) {
+                    points[i] = chunk->vertices[i].position;
+                }
+                sdl_transform_points(&t, points, count);
+                ok = SDL_RenderGeometryRaw(ud->renderer, map->texture,
+                                           &points[0].x, sizeof(SDL_FPoint),
+                                           &chunk->vertices[0].color, sizeof(SDL_Vertex),
+                                           &chunk->vertices[0].tex_coord.x, sizeof(SDL_Vertex),
+                                           count, map->indices, chunk->quads * 6, sizeof(int));
+            }
+            if (!ok) {
+                luaL_error(L, "Failed to render tilemap: %s", SDL_GetError());
+            }
+            drawn++;
+        }
+    }
+    lua_pushinteger(L, drawn);
+    return 1;
+}
+
+static const struct luaL_Reg tilemap_lib[] = {
+    {"create_tilemap", l_sdl_create_tilemap},
+    {"tilemap_set", l_sdl_tilemap_set},
+    {"tilemap_get", l_sdl_tilemap_get},
+    {"tilemap_fill", l_sdl_tilemap_fill},
+    {"tilemap_load", l_sdl_tilemap_load},
+    {"tilemap_size", l_sdl_tilemap_size},
+    {"render_tilemap", l_sdl_render_tilemap},
+    {NULL, NULL}
+};
+
+// Create the tilemap metatable and add the tilemap functions.
+void sdl_tilemap_register(lua_State* L) {
+    luaL_newmetatable(L, TILEMAP_MT);
+    lua_pushcfunction(L, tilemap_gc);
+    lua_setfield(L, -2, "__gc");
+    lua_pop(L, 1);
+
+    luaL_setfuncs(L, tilemap_lib, 0);
+}
@@ -0,0 +1,291 @@
+// sdl_transform.c
+// Per-renderer affine transform stack (push/pop/translate/scale/rotate) and the
+// vectorized kernels that apply it to packed point and vertex arrays.
+#include "module_sdl.h"
+#include <string.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define SDL_TRANSFORM_SSE2 1
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define SDL_TRANSFORM_NEON 1
+#endif
+
+void sdl_transform_identity(sdl_transform* t) {
+    t->a = 1.0f; t->b = 0.0f;
+    t->c = 0.0f; t->d = 1.0f;
+    t->tx = 0.0f; t->ty = 0.0f;
+}
+
+bool sdl_transform_is_identity(const sdl_transform* t) {
+    return t->a == 1.0f && t->b == 0.0f && t->c == 0.0f && t->d == 1.0f && t->tx == 0.0f && t->ty == 0.0f;
+}
+
+// Uniform scale estimate (used to pick tessellation detail in screen space).
+float sdl_transform_scale(const sdl_transform* t) {
+    return SDL_sqrtf(SDL_fabsf(t->a * t->d - t->b * t->c));
+}
+
+void sdl_transform_point(const sdl_transform* t, float* x, float* y) {
+    float px = *x, py = *y;
+    *x = t->a * px + t->c * py + t->tx;
+    *y = t->b * px + t->d * py + t->ty;
+}
+
+// Transform `count` (x, y) float pairs spaced `stride` bytes apart, in place.
+void sdl_transform_strided(const sdl_transform* t, float* xy, int count, size_t stride) {
+    if (count <= 0 || sdl_transform_is_identity(t)) {
+        return;
+    }
+    Uint8* p = (Uint8*)xy;
+    int i = 0;
+
+#if defined(SDL_TRANSFORM_SSE2)
+    // Two points per register: [x0 y0 x1 y1] -> [x0 x0 x1 x1]*[a b a b] + [y0 y0 y1 y1]*[c d c d] + [tx ty tx ty]
+    const __m128 m_ab = _mm_setr_ps(t->a, t->b, t->a, t->b);
+    const __m128 m_cd = _mm_setr_ps(t->c, t->d, t->c, t->d);
+    const __m128 m_t = _mm_setr_ps(t->tx, t->ty, t->tx, t->ty);
+    if (stride == 2 * sizeof(float)) {
+        float* f = xy;
+        for (; i + 4 <= count; i += 4) {
+            __m128 p0 = _mm_loadu_ps(f + i * 2);
+            __m128 p1 = _mm_loadu_ps(f + i * 2 + 4);
+            __m128 r0 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_shuffle_ps(p0, p0, _MM_SHUFFLE(2, 2, 0, 0)), m_ab),
+                                              _mm_mul_ps(_mm_shuffle_ps(p0, p0, _MM_SHUFFLE(3, 3, 1, 1)), m_cd)), m_t);
+            __m128 r1 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_shuffle_ps(p1, p1, _MM_SHUFFLE(2, 2, 0, 0)), m_ab),
+                                              _mm_mul_ps(_mm_shuffle_ps(p1, p1, _MM_SHUFFLE(3, 3, 1, 1)), m_cd)), m_t);
+            _mm_storeu_ps(f + i * 2, r0);
+            _mm_storeu_ps(f + i * 2 + 4, r1);
+        }
+    } else {
+        for (; i + 2 <= count; i += 2) {
+            __m64* q0 = (__m64*)(p + (size_t)i * stride);
+            __m64* q1 = (__m64*)(p + (size_t)(i + 1) * stride);
+            __m128 v = _mm_loadh_pi(_mm_loadl_pi(_mm_setzero_ps(), q0), q1);
+            __m128 r = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 2, 0, 0)), m_ab),
+                                             _mm_mul_ps(_mm_shuffle_ps(v, v, _MM_SHUFFLE(3, 3, 1, 1)), m_cd)), m_t);
+            _mm_storel_pi(q0, r);
+            _mm_storeh_pi(q1, r);
+        }
+    }
+#elif defined(SDL_TRANSFORM_NEON)
+    if (stride == 2 * sizeof(float)) {
+        // De-interleave four points: x' = a*x + c*y + tx, y' = b*x + d*y + ty
+        const float32x4_t va = vdupq_n_f32(t->a), vb = vdupq_n_f32(t->b);
+        const float32x4_t vc = vdupq_n_f32(t->c), vd = vdupq_n_f32(t->d);
+        const float32x4_t vtx = vdupq_n_f32(t->tx), vty = vdupq_n_f32(t->ty);
+        for (; i + 4 <= count; i += 4) {
+            float32x4x2_t v = vld2q_f32(xy + i * 2);
+            float32x4x2_t r;
+            r.val[0] = vmlaq_f32(vmlaq_f32(vtx, va, v.val[0]), vc, v.val[1]);
+            r.val[1] = vmlaq_f32(vmlaq_f32(vty, vb, v.val[0]), vd, v.val[1]);
+            vst2q_f32(xy + i * 2, r);
+        }
+    }
+#endif
+
+    for (; i < count; i++) {
+        float* q = (float*)(p + (size_t)i * stride);
+        sdl_transform_point(t, &q[0], &q[1]);
+    }
+}
+
+void sdl_transform_points(const sdl_transform* t, SDL_FPoint* points, int count) {
+    sdl_transform_strided(t, &points[0].x, count, sizeof(SDL_FPoint));
+}
+
+void sdl_transform_vertices(const sdl_transform* t, SDL_Vertex* vertices, int count) {
+    sdl_transform_strided(t, &vertices[0].position.x, count, sizeof(SDL_Vertex));
+}
+
+// Transform the batch vertices appended since the last call. Runs before the
+// transform changes and before the batch is submitted.
+void sdl_batch_apply_transform(lua_SDL_Renderer* ud) {
+    sdl_batch* batch = &ud->batch;
+    if (batch->transformed < batch->vertex_count) {
+        sdl_transform_vertices(&ud->transform, batch->vertices + batch->transformed,
+                               batch->vertex_count - batch->transformed);
+    }
+    batch->transformed = batch->vertex_count;
+}
+
+// World space bounding box of the current viewport (used for culling).
+bool sdl_view_bounds(lua_SDL_Renderer* ud, SDL_FRect* bounds) {
+    SDL_Rect viewport;
+    if (!SDL_GetRenderViewport(ud->renderer, &viewport)) {
+        return false;
+    }
+
+    const sdl_transform* t = &ud->transform;
+    float det = t->a * t->d - t->b * t->c;
+    if (det == 0.0f) {
+        return false;
+    }
+
+    // Inverse transform the four viewport corners
+    const float sx[4] = { 0.0f, (float)viewport.w, 0.0f, (float)viewport.w };
+    const float sy[4] = { 0.0f, 0.0f, (float)viewport.h, (float)viewport.h };
+    float min_x = 0.0f, min_y = 0.0f, max_x = 0.0f, max_y = 0.0f;
+    for (int i = 0; i < 4; i++) {
+        float px = sx[i] - t->tx, py = sy[i] - t->ty;
+        float wx = (t->d * px - t->c * py) / det;
+        float wy = (t->a * py - t->b * px) / det;
+        if (i == 0 || wx < min_x) min_x = wx;
+        if (i == 0 || wy < min_y) min_y = wy;
+        if (i == 0 || wx > max_x) max_x = wx;
+        if (i == 0 || wy > max_y) max_y = wy;
+    }
+    bounds->x = min_x;
+    bounds->y = min_y;
+    bounds->w = max_x - min_x;
+    bounds->h = max_y - min_y;
+    return true;
+}
+
+// Renderer whose transform is about to change: pending batch vertices keep the old one.
+static lua_SDL_Renderer* check_transform_renderer(lua_State* L, int idx) {
+    lua_SDL_Renderer* ud = lua_check_SDL_Renderer(L, idx);
+    sdl_batch_apply_transform(ud);
+    return ud;
+}
+
+// Save the current transform: sdl.push_transform(renderer)
+static int l_sdl_push_transform(lua_State* L) {
+    lua_SDL_Renderer* ud = check_transform_renderer(L, 1);
+    if (ud->transform_depth >= SDL_TRANSFORM_STACK_MAX) {
+        luaL_error(L, "Transform stack overflow (max %d)", SDL_TRANSFORM_STACK_MAX);
+    }
+    ud->transform_stack[ud->transform_depth++] = ud->transform;
+    return 0;
+}
+
+// Restore the last pushed transform: sdl.pop_transform(renderer)
+static int l_sdl_pop_transform(lua_State* L) {
+    lua_SDL_Renderer* ud = check_transform_renderer(L, 1);
+    if (ud->transform_depth <= 0) {
+        luaL_error(L, "Transform stack underflow");
+    }
+    ud->transform = ud->transform_stack[--ud->transform_depth];
+    return 0;
+}
+
+// Reset to identity: sdl.reset_transform(renderer)
+static int l_sdl_reset_transform(lua_State* L) {
+    lua_SDL_Renderer* ud = check_transform_renderer(L, 1);
+    sdl_transform_identity(&ud->transform);
+    return 0;
+}
+
+// Move the origin: sdl.translate(renderer, x, y)
+static int l_sdl_translate(lua_State* L) {
+    lua_SDL_Renderer* ud = check_transform_renderer(L, 1);
+    float x = (float)luaL_checknumber(L, 2);
+    float y = (float)luaL_checknumber(L, 3);
+
+    sdl_transform* t = &ud->transform;
+    t->tx += t->a * x + t->c * y;
+    t->ty += t->b * x + t->d * y;
+    return 0;
+}
+
+// Scale the axes: sdl.scale(renderer, sx, [sy])
+static int l_sdl_scale(lua_State* L) {
+    lua_SDL_Renderer* ud = check_transform_renderer(L, 1);
+    float sx = (float)luaL_checknumber(L, 2);
+    float sy = (float)luaL_optnumber(L, 3, sx);
+
+    sdl_transform* t = &ud->transform;
+    t->a *= sx; t->b *= sx;
+    t->c *= sy; t->d *= sy;
+    return 0;
+}
+
+// Rotate the axes (radians, clockwise on screen): sdl.rotate(renderer, angle)
+static int l_sdl_rotate(lua_State* L) {
+    lua_SDL_Renderer* ud = check_transform_renderer(L, 1);
+    float angle = (float)luaL_checknumber(L, 2);
+    float cs = SDL_cosf(angle), sn = SDL_sinf(angle);
+
+    sdl_transform* t = &ud->transform;
+    float a = t->a, b = t->b, c = t->c, d = t->d;
+    t->a = a * cs + c * sn;
+    t->b = b * cs + d * sn;
+    t->c = c * cs - a * sn;
+    t->d = d * cs - b * sn;
+    return 0;
+}
+
+// Replace the transform: sdl.set_transform(renderer, a, b, c, d, tx, ty)
+static int l_sdl_set_transform(lua_State* L) {
+    lua_SDL_Renderer* ud = check_transform_renderer(L, 1);
+    sdl_transform* t = &ud->transform;
+    t->a = (float)luaL_checknumber(L, 2);
+    t->b = (float)luaL_checknumber(L, 3);
+    t->c = (float)luaL_checknumber(L, 4);
+    t->d = (float)luaL_checknumber(L, 5);
+    t->tx = (float)luaL_checknumber(L, 6);
+    t->ty = (float)luaL_checknumber(L, 7);
+    return 0;
+}
+
+// Current transform: sdl.get_transform(renderer) -> a, b, c, d, tx, ty
+static int l_sdl_get_transform(lua_State* L) {
+    lua_SDL_Renderer* ud = lua_check_SDL_Renderer(L, 1);
+    const sdl_transform* t = &ud->transform;
+    lua_pushnumber(L, t->a);
+    lua_pushnumber(L, t->b);
+    lua_pushnumber(L, t->c);
+    lua_pushnumber(L, t->d);
+    lua_pushnumber(L, t->tx);
+    lua_pushnumber(L, t->ty);
+    return 6;
+}
+
+// World to screen: sdl.transform_point(renderer, x, y) -> x, y
+static int l_sdl_transform_point(lua_State* L) {
+    lua_SDL_Renderer* ud = lua_check_SDL_Renderer(L, 1);
+    float x = (float)luaL_checknumber(L, 2);
+    float y = (float)luaL_checknumber(L, 3);
+
+    sdl_transform_point(&ud->transform, &x, &y);
+    lua_pushnumber(L, x);
+    lua_pushnumber(L, y);
+    return 2;
+}
+
+// Screen to world (e.g. mouse picking): sdl.inverse_transform_point(renderer, x, y) -> x, y
+static int l_sdl_inverse_transform_point(lua_State* L) {
+    lua_SDL_Renderer* ud = lua_check_SDL_Renderer(L, 1);
+    float x = (float)luaL_checknumber(L, 2);
+    float y = (float)luaL_checknumber(L, 3);
+
+    const sdl_transform* t = &ud->transform;
+    float det = t->a * t->d - t->b * t->c;
+    if (det == 0.0f) {
+        luaL_error(L, "Transform is not invertible");
+    }
+    float px = x - t->tx, py = y - t->ty;
+    lua_pushnumber(L, (t->d * px - t->c * py) / det);
+    lua_pushnumber(L, (t->a * py - t->b * px) / det);
+    return 2;
+}
+
+static const struct luaL_Reg transform_lib[] = {
+    {"push_transform", l_sdl_push_transform},
+    {"pop_transform", l_sdl_pop_transform},
+    {"reset_transform", l_sdl_reset_transform},
+    {"translate", l_sdl_translate},
+    {"scale", l_sdl_scale},
+    {"rotate", l_sdl_rotate},
+    {"set_transform", l_sdl_set_transform},
+    {"get_transform", l_sdl_get_transform},
+    {"transform_point", l_sdl_transform_point},
+    {"inverse_transform_point", l_sdl_inverse_transform_point},
+    {NULL, NULL}
+};
+
+// Add the transform functions to the sdl module table on top of the stack.
+void sdl_transform_register(lua_State* L) {
+    luaL_setfuncs(L, transform_lib, 0);
+}
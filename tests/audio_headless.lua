@@ -0,0 +1,43 @@
+-- Headless mixer check, run by ctest under SDL's dummy audio driver:
+--   sdl3_lua --headless tests/audio_headless.lua
+-- Streams a WAV file from disk for a second and fails unless the mixer
+-- produced buffers without a single underrun.
+local sdl = require 'sdl'
+
+local function write_wav(path, freq, seconds, rate)
+    local samples = {}
+    local count = math.floor(seconds * rate)
+    for i = 0, count - 1 do
+        local s = math.floor(math.sin(2 * math.pi * freq * i / rate) * 8000)
+        samples[#samples + 1] = string.pack("<i2<i2", s, s)
+    end
+    local data = table.concat(samples)
+    local f = assert(io.open(path, "wb"))
+    f:write("RIFF", string.pack("<I4", 36 + #data), "WAVE",
+        "fmt ", string.pack("<I4I2I2I4I4I2I2", 16, 1, 2, rate, rate * 4, 4, 16),
+        "data", string.pack("<I4", #data), data)
+    f:close()
+end
+
+local path = os.tmpname()
+write_wav(path, 220, 3.0, 44100) -- not the mixing rate, so the stream is resampled
+
+local driver = sdl.open_audio(48000)
+local stream = sdl.open_sound_stream(path)
+local voice = assert(sdl.play_stream(stream, 0.5), "no free voice")
+
+local start = sdl.get_ticks()
+while sdl.get_ticks() - start < 1000 do
+    sdl.poll_events()
+end
+
+local buffers, avg_us, max_us, load, voices, underruns = sdl.audio_stats()
+print(string.format("audio %s: buffers %d  underruns %d  voices %d  mix avg %.1f us  max %.1f us",
+    driver, buffers, underruns, voices, avg_us, max_us))
+local playing = sdl.voice_playing(voice)
+sdl.close_audio()
+os.remove(path)
+
+assert(buffers > 0, "mixer produced no buffers")
+assert(underruns == 0, "stream underran " .. underruns .. " times")
+assert(playing, "stream stopped before its end")